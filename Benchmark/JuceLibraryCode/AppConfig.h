@@ -0,0 +1,29 @@
+/*
+  ==============================================================================
+
+    Module configuration of the headless benchmark, which only uses the
+    non-GUI modules of JUCE.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#define JUCE_GLOBAL_MODULE_SETTINGS_INCLUDED 1
+
+#define JUCE_MODULE_AVAILABLE_juce_core             1
+#define JUCE_MODULE_AVAILABLE_juce_audio_basics     1
+#define JUCE_MODULE_AVAILABLE_juce_audio_formats    1
+#define JUCE_MODULE_AVAILABLE_juce_dsp              1
+
+#ifndef JUCE_STANDALONE_APPLICATION
+ #define JUCE_STANDALONE_APPLICATION 1
+#endif
+
+#ifndef JUCE_USE_CURL
+ #define JUCE_USE_CURL 0
+#endif
+
+#ifndef JUCE_CHECK_MEMORY_LEAKS
+ #define JUCE_CHECK_MEMORY_LEAKS 0
+#endif
@@ -0,0 +1,27 @@
+/*
+  ==============================================================================
+
+    Includes the JUCE modules used by the headless benchmark.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "AppConfig.h"
+
+#include <juce_core/juce_core.h>
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+
+#if ! DONT_SET_USING_JUCE_NAMESPACE
+ using namespace juce;
+#endif
+
+namespace ProjectInfo
+{
+    const char* const  projectName    = "OverlappingFFTProcessorBenchmark";
+    const char* const  versionString  = "1.0.0";
+    const int          versionNumber  = 0x10000;
+}
@@ -0,0 +1,2 @@
+#include "AppConfig.h"
+#include <juce_audio_basics/juce_audio_basics.cpp>
@@ -0,0 +1,2 @@
+#include "AppConfig.h"
+#include <juce_audio_formats/juce_audio_formats.cpp>
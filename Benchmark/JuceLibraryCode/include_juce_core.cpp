@@ -0,0 +1,2 @@
+#include "AppConfig.h"
+#include <juce_core/juce_core.cpp>
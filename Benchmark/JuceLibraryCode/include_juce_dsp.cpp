@@ -0,0 +1,2 @@
+#include "AppConfig.h"
+#include <juce_dsp/juce_dsp.cpp>
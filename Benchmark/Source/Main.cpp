@@ -0,0 +1,1284 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+/*
+ Headless benchmark of OverlappingFFTProcessor::process(). It runs a grid of
+ (fftSize, hopSize divider, host block size, channel count) and reports for each case
+ the processing time per sample, the worst-case callback time and the allocations per callback.
+ The results are written as JSON, so they can be compared across releases.
+ With --verify, it checks the correctness of the buffering, of resolution changes, of the SpectrumTap, of the
+ OfflineRenderer, of the partitioned convolutions and of the multi-resolution processor instead (exit code 1 on failure).
+ */
+
+#include <JuceHeader.h>
+#include <iostream>
+#include "OverlappingFFTProcessor.h"
+#include "OfflineRenderer.h"
+#include "PartitionedConvolution.h"
+#include "MultiResolutionFFTProcessor.h"
+
+#ifndef BENCHMARK_REVISION
+ #define BENCHMARK_REVISION ""
+#endif
+
+//==============================================================================
+// every allocation increments this counter, the benchmark reads it before and after each callback
+static std::atomic<int64> numAllocations { 0 };
+
+#if BENCHMARK_WRAP_MALLOC
+// linked with --wrap, so also the allocations of HeapBlock & co. are counted
+extern "C"
+{
+    void* __real_malloc (size_t);
+    void* __real_calloc (size_t, size_t);
+    void* __real_realloc (void*, size_t);
+
+    void* __wrap_malloc (size_t size)
+    {
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+        return __real_malloc (size);
+    }
+
+    void* __wrap_calloc (size_t num, size_t size)
+    {
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+        return __real_calloc (num, size);
+    }
+
+    void* __wrap_realloc (void* ptr, size_t size)
+    {
+        numAllocations.fetch_add (1, std::memory_order_relaxed);
+        return __real_realloc (ptr, size);
+    }
+}
+#endif
+
+void* operator new (size_t size)
+{
+   #if ! BENCHMARK_WRAP_MALLOC
+    numAllocations.fetch_add (1, std::memory_order_relaxed);
+   #endif
+
+    if (auto* ptr = std::malloc (size > 0 ? size : 1))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (size_t size) { return operator new (size); }
+void operator delete (void* ptr) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr) noexcept { std::free (ptr); }
+void operator delete (void* ptr, size_t) noexcept { std::free (ptr); }
+void operator delete[] (void* ptr, size_t) noexcept { std::free (ptr); }
+
+//==============================================================================
+using Resolution = OverlappingFFTProcessorBase::Resolution;
+using FrameDomain = OverlappingFFTProcessorBase::FrameDomain;
+using FrameScheduling = OverlappingFFTProcessorBase::FrameScheduling;
+using ActivityDetection = OverlappingFFTProcessorBase::ActivityDetection;
+
+/** Simple spectral low pass, implemented for each frame domain, so all of them do the same work. */
+template <typename SampleType>
+class BenchmarkProcessor : public BasicOverlappingFFTProcessor<SampleType>
+{
+public:
+    BenchmarkProcessor (const Resolution resolution, const FrameDomain domain, const FrameScheduling scheduling)
+    : BasicOverlappingFFTProcessor<SampleType> (resolution), gains ((size_t) resolution.fftSize / 2 + 1, (SampleType) 0.1)
+    {
+        this->setFrameDomain (domain);
+        this->setFrameScheduling (scheduling);
+
+        std::fill (gains.begin(), gains.begin() + (int) gains.size() / 4, (SampleType) 1);
+    }
+
+    ~BenchmarkProcessor() { this->releaseResources(); }
+
+    /** In matrix domain, the low pass is on the diagonal of a full mixing matrix, which is applied to all channels. */
+    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels)
+    {
+        if (this->getFrameDomain() == FrameDomain::matrix)
+        {
+            const int numBins = (int) gains.size();
+            matrix.setSize (numOutputChannels * numInputChannels, numBins);
+
+            for (int ch = 0; ch < jmin (numInputChannels, numOutputChannels); ++ch)
+                FloatVectorOperations::copy (matrix.getRealPointer (ch * numInputChannels + ch), gains.data(), numBins);
+        }
+
+        BasicOverlappingFFTProcessor<SampleType>::prepare (sampleRate, maximumBlockSize, numInputChannels, numOutputChannels);
+    }
+
+private:
+    void processFrame (const int channel, SampleType* data) override
+    {
+        ignoreUnused (channel);
+        this->fft.performRealOnlyForwardTransform (data, true);
+        applyGains (data);
+        this->fft.performRealOnlyInverseTransform (data);
+    }
+
+    void processSpectrumInBuffer (const int maxNumChannels) override
+    {
+        for (int ch = 0; ch < maxNumChannels; ++ch)
+            applyGains (this->fftInOutBuffer.getWritePointer (ch));
+    }
+
+    void processSplitSpectrumInBuffer (const int maxNumChannels) override
+    {
+        ignoreUnused (maxNumChannels);
+        this->spectrumBuffer.applyGains (gains.data());
+    }
+
+    void processMatrixSpectra (const int numInputChannels, const int numOutputChannels) override
+    {
+        ignoreUnused (numInputChannels, numOutputChannels);
+        this->outputSpectra.setToMatrixProduct (matrix, this->inputSpectra);
+    }
+
+    void applyGains (SampleType* spectrum) const noexcept
+    {
+        for (size_t k = 0; k < gains.size(); ++k)
+        {
+            spectrum[2 * k] *= gains[k];
+            spectrum[2 * k + 1] *= gains[k];
+        }
+    }
+
+    std::vector<SampleType> gains;
+    SplitComplexBuffer<SampleType> matrix;
+};
+
+//==============================================================================
+struct Settings
+{
+    Array<int> fftSizes { 256, 1024, 4096 };
+    Array<int> hopSizeDividers { 2, 4 };
+    Array<int> blockSizes { 1, 31, 64, 256, 1023 };
+    Array<int> channelCounts { 1, 2, 16, 64 };
+
+    FrameDomain domain = FrameDomain::frequency;
+    FrameScheduling scheduling = FrameScheduling::synchronous;
+    bool useDoublePrecision = false;
+    int numWorkerThreads = 0;
+    double sampleRate = 48000.0;
+    double secondsPerCase = 2.0;
+    String outputFile;
+};
+
+struct BenchmarkCase
+{
+    int fftSize;
+    int hopSizeDivider;
+    int blockSize;
+    int numChannels;
+};
+
+struct Result
+{
+    int hopSize = 0;
+    int latency = 0;
+    int64 numCallbacks = 0;
+    int64 numSamples = 0;
+    double nsPerSample = 0.0;
+    double nsPerChannelSample = 0.0;
+    double meanCallbackNs = 0.0;
+    double worstCallbackNs = 0.0;
+    double allocationsPerCallback = 0.0;
+    int64 maxAllocationsPerCallback = 0;
+    var stages;
+};
+
+static String getName (const FrameDomain domain)
+{
+    switch (domain)
+    {
+        case FrameDomain::time: return "time";
+        case FrameDomain::frequency: return "frequency";
+        case FrameDomain::splitComplex: return "splitComplex";
+        case FrameDomain::matrix: return "matrix";
+    }
+
+    return {};
+}
+
+static String getName (const FrameScheduling scheduling)
+{
+    switch (scheduling)
+    {
+        case FrameScheduling::synchronous: return "synchronous";
+        case FrameScheduling::background: return "background";
+        case FrameScheduling::amortized: return "amortized";
+    }
+
+    return {};
+}
+
+static double ticksToNs (const int64 ticks)
+{
+    return Time::highResolutionTicksToSeconds (ticks) * 1.0e9;
+}
+
+//==============================================================================
+template <typename SampleType>
+static Result runCase (const BenchmarkCase& benchmarkCase, const Settings& settings)
+{
+    const int hopSize = jmax (1, benchmarkCase.fftSize / benchmarkCase.hopSizeDivider);
+    const int blockSize = benchmarkCase.blockSize;
+    const int numChannels = benchmarkCase.numChannels;
+
+    BenchmarkProcessor<SampleType> processor ({ benchmarkCase.fftSize, hopSize }, settings.domain, settings.scheduling);
+    processor.setNumWorkerThreads (settings.numWorkerThreads);
+    processor.prepare (settings.sampleRate, blockSize, numChannels, numChannels);
+
+    AudioBuffer<SampleType> input (numChannels, blockSize);
+    AudioBuffer<SampleType> buffer (numChannels, blockSize);
+
+    Random random (42);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < blockSize; ++i)
+            input.setSample (ch, i, (SampleType) (2.0f * random.nextFloat() - 1.0f));
+
+    dsp::AudioBlock<SampleType> block (buffer);
+    dsp::ProcessContextReplacing<SampleType> context (block);
+
+    ScopedNoDenormals noDenormals;
+
+    // fill the buffers and get the threads going, before anything is measured
+    const int numWarmUpCallbacks = (processor.getLatencyInSamples() + 2 * benchmarkCase.fftSize) / blockSize + 8;
+    for (int i = 0; i < numWarmUpCallbacks; ++i)
+    {
+        buffer.makeCopyOf (input, true);
+        processor.process (context);
+    }
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    processor.getStatistics().reset();
+   #endif
+
+    Result result;
+    result.hopSize = hopSize;
+    result.latency = processor.getLatencyInSamples();
+    result.numCallbacks = jmax ((int64) 1, (int64) (settings.secondsPerCase * settings.sampleRate) / blockSize);
+    result.numSamples = result.numCallbacks * blockSize;
+
+    int64 totalTicks = 0;
+    int64 worstTicks = 0;
+    int64 totalAllocations = 0;
+
+    for (int64 i = 0; i < result.numCallbacks; ++i)
+    {
+        buffer.makeCopyOf (input, true);
+
+        const auto allocationsBefore = numAllocations.load (std::memory_order_relaxed);
+        const auto start = Time::getHighResolutionTicks();
+
+        processor.process (context);
+
+        const auto ticks = Time::getHighResolutionTicks() - start;
+        const auto allocations = numAllocations.load (std::memory_order_relaxed) - allocationsBefore;
+
+        totalTicks += ticks;
+        worstTicks = jmax (worstTicks, ticks);
+        totalAllocations += allocations;
+        result.maxAllocationsPerCallback = jmax (result.maxAllocationsPerCallback, allocations);
+    }
+
+    const double totalNs = ticksToNs (totalTicks);
+    result.nsPerSample = totalNs / result.numSamples;
+    result.nsPerChannelSample = result.nsPerSample / numChannels;
+    result.meanCallbackNs = totalNs / result.numCallbacks;
+    result.worstCallbackNs = ticksToNs (worstTicks);
+    result.allocationsPerCallback = (double) totalAllocations / result.numCallbacks;
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    DynamicObject::Ptr stages (new DynamicObject());
+    for (int stage = 0; stage < ProcessorStatistics::numStages; ++stage)
+    {
+        const auto& histogram = processor.getStatistics().getHistogram ((ProcessorStatistics::Stage) stage);
+
+        DynamicObject::Ptr measurement (new DynamicObject());
+        measurement->setProperty ("count", (int64) histogram.getNumValues());
+        measurement->setProperty ("mean", histogram.getMean());
+        measurement->setProperty ("max", (int64) histogram.getMaximum());
+        stages->setProperty (ProcessorStatistics::getStageName ((ProcessorStatistics::Stage) stage), measurement.get());
+    }
+    result.stages = stages.get();
+   #endif
+
+    return result;
+}
+
+static var toJSON (const BenchmarkCase& benchmarkCase, const Result& result)
+{
+    DynamicObject::Ptr object (new DynamicObject());
+
+    object->setProperty ("fftSize", benchmarkCase.fftSize);
+    object->setProperty ("hopSizeDivider", benchmarkCase.hopSizeDivider);
+    object->setProperty ("hopSize", result.hopSize);
+    object->setProperty ("blockSize", benchmarkCase.blockSize);
+    object->setProperty ("numChannels", benchmarkCase.numChannels);
+    object->setProperty ("latency", result.latency);
+    object->setProperty ("numCallbacks", result.numCallbacks);
+    object->setProperty ("nsPerSample", result.nsPerSample);
+    object->setProperty ("nsPerChannelSample", result.nsPerChannelSample);
+    object->setProperty ("meanCallbackNs", result.meanCallbackNs);
+    object->setProperty ("worstCallbackNs", result.worstCallbackNs);
+    object->setProperty ("allocationsPerCallback", result.allocationsPerCallback);
+    object->setProperty ("maxAllocationsPerCallback", result.maxAllocationsPerCallback);
+
+    if (! result.stages.isVoid())
+        object->setProperty ("stages", result.stages);
+
+    return object.get();
+}
+
+static var getEnvironment (const Settings& settings)
+{
+    DynamicObject::Ptr object (new DynamicObject());
+
+    object->setProperty ("revision", BENCHMARK_REVISION);
+    object->setProperty ("date", Time::getCurrentTime().toISO8601 (true));
+    object->setProperty ("juceVersion", SystemStats::getJUCEVersion());
+    object->setProperty ("operatingSystem", SystemStats::getOperatingSystemName());
+    object->setProperty ("cpuVendor", SystemStats::getCpuVendor());
+    object->setProperty ("cpuSpeedMHz", SystemStats::getCpuSpeedInMegahertz());
+    object->setProperty ("numCpus", SystemStats::getNumCpus());
+    if (settings.useDoublePrecision)
+    {
+        object->setProperty ("sampleType", "double");
+        object->setProperty ("simdLanes", BatchedRealFFT<double>::numLanes);
+        object->setProperty ("fftBackend", SharedResourcePointer<FFTPlanCache<double>>()->getPlan (1024)->getName());
+    }
+    else
+    {
+        object->setProperty ("sampleType", "float");
+        object->setProperty ("simdLanes", BatchedRealFFT<float>::numLanes);
+        object->setProperty ("fftBackend", SharedResourcePointer<FFTPlanCache<float>>()->getPlan (1024)->getName());
+    }
+
+   #if BENCHMARK_WRAP_MALLOC
+    object->setProperty ("countedAllocations", "malloc, calloc, realloc, operator new");
+   #else
+    object->setProperty ("countedAllocations", "operator new");
+   #endif
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    object->setProperty ("stageDurationUnit", ProcessorStatistics::getCounterName());
+   #endif
+   #if JUCE_DEBUG
+    object->setProperty ("build", "debug");
+   #else
+    object->setProperty ("build", "release");
+   #endif
+
+    object->setProperty ("frameDomain", getName (settings.domain));
+    object->setProperty ("frameScheduling", getName (settings.scheduling));
+    object->setProperty ("numWorkerThreads", settings.numWorkerThreads);
+    object->setProperty ("sampleRate", settings.sampleRate);
+    object->setProperty ("secondsPerCase", settings.secondsPerCase);
+
+    return object.get();
+}
+
+//==============================================================================
+/*
+ Verification: unaltered frames have to be reconstructed perfectly, delayed by exactly the reported latency,
+ independent of the host block sizes, and for any number of input and output channels.
+ */
+struct VerificationCase
+{
+    Resolution resolution;
+    FrameDomain domain;
+    FrameScheduling scheduling;
+    int numInputChannels;
+    int numOutputChannels;
+    int numWorkerThreads;
+    int synthesisWindowLength;
+};
+
+/** Runs the input through an identity processor, with the given block sizes (cycled). */
+template <typename SampleType>
+static AudioBuffer<SampleType> processIdentity (const VerificationCase& verificationCase, const AudioBuffer<SampleType>& input,
+                                                const Array<int>& blockSizes, const int maximumBlockSize, int& latency)
+{
+    // without any overrides, the processor leaves the frames unaltered
+    BasicOverlappingFFTProcessor<SampleType> processor (verificationCase.resolution);
+    processor.setFrameDomain (verificationCase.domain);
+    processor.setFrameScheduling (verificationCase.scheduling);
+    processor.setNumWorkerThreads (verificationCase.numWorkerThreads);
+    processor.setSynthesisWindowLength (verificationCase.synthesisWindowLength);
+    processor.prepare (48000.0, maximumBlockSize, verificationCase.numInputChannels, verificationCase.numOutputChannels);
+    latency = processor.getLatencyInSamples();
+
+    const int numChannels = jmax (verificationCase.numInputChannels, verificationCase.numOutputChannels);
+    const int numSamples = input.getNumSamples();
+    AudioBuffer<SampleType> output (numChannels, numSamples);
+    AudioBuffer<SampleType> buffer (numChannels, maximumBlockSize);
+    dsp::AudioBlock<SampleType> block (buffer);
+
+    Random random (7);
+    for (int position = 0, i = 0; position < numSamples; ++i)
+    {
+        const int blockSize = jmin (blockSizes[i % blockSizes.size()], numSamples - position);
+
+        // the channels the processor doesn't expect as input are filled with noise, they must not be used
+        for (int ch = 0; ch < numChannels; ++ch)
+            for (int n = 0; n < blockSize; ++n)
+                buffer.setSample (ch, n, ch < verificationCase.numInputChannels ? input.getSample (ch, position + n) : (SampleType) random.nextFloat());
+
+        auto subBlock = block.getSubBlock (0, (size_t) blockSize);
+        processor.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            output.copyFrom (ch, position, buffer, ch, 0, blockSize);
+
+        position += blockSize;
+    }
+
+    processor.releaseResources();
+    return output;
+}
+
+/** Returns an empty string if the case passes, or a description of what went wrong. */
+template <typename SampleType>
+static String verify (const VerificationCase& verificationCase)
+{
+    const int fftSize = verificationCase.resolution.fftSize;
+    const int hopSize = verificationCase.resolution.hopSize;
+    const int numSamples = 8 * fftSize + 3000;
+    const int maximumBlockSize = 1024;
+
+    Random random (42);
+    AudioBuffer<SampleType> input (verificationCase.numInputChannels, numSamples);
+    for (int ch = 0; ch < input.getNumChannels(); ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            input.setSample (ch, n, (SampleType) (2.0 * random.nextDouble() - 1.0));
+
+    // awkward block sizes, including empty blocks
+    Array<int> variableBlockSizes;
+    for (int i = 0; i < 200; ++i)
+    {
+        const int choice = random.nextInt (4);
+        variableBlockSizes.add (choice == 0 ? random.nextInt (3) : (choice == 1 ? maximumBlockSize : random.nextInt (maximumBlockSize + 1)));
+    }
+
+    int latency = 0, latencyWithVariableBlockSizes = 0;
+    const auto output = processIdentity (verificationCase, input, { 64 }, maximumBlockSize, latency);
+    const auto outputWithVariableBlockSizes = processIdentity (verificationCase, input, variableBlockSizes, maximumBlockSize, latencyWithVariableBlockSizes);
+
+    const bool isDeferred = verificationCase.scheduling != FrameScheduling::synchronous;
+    const int synthesisLength = verificationCase.synthesisWindowLength > 0 ? verificationCase.synthesisWindowLength : fftSize;
+    const int expectedLatency = synthesisLength - 1 + (isDeferred ? hopSize : 0);
+    if (latency != expectedLatency || latencyWithVariableBlockSizes != expectedLatency)
+        return "latency is " + String (latency) + " instead of " + String (expectedLatency);
+
+    for (int ch = 0; ch < output.getNumChannels(); ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            if (output.getSample (ch, n) != outputWithVariableBlockSizes.getSample (ch, n))
+                return "output depends on the block sizes (channel " + String (ch) + ", sample " + String (n) + ")";
+
+    // the offline renderer has to return the same samples, without latency. Amortized scheduling never transforms
+    // the channels in batches, so it might differ by rounding errors.
+    OfflineRenderer<SampleType> renderer ([&verificationCase]
+                                          {
+                                              std::unique_ptr<BasicOverlappingFFTProcessor<SampleType>> processor (new BasicOverlappingFFTProcessor<SampleType> (verificationCase.resolution));
+                                              processor->setFrameDomain (verificationCase.domain);
+                                              processor->setSynthesisWindowLength (verificationCase.synthesisWindowLength);
+                                              return processor;
+                                          }, 3);
+    AudioBuffer<SampleType> offlineOutput (verificationCase.numOutputChannels, numSamples);
+    renderer.process (input, offlineOutput, 48000.0);
+
+    // In double precision, anything worse than rounding errors means that some stage converted to float.
+    const SampleType tolerance = (SampleType) (sizeof (SampleType) == sizeof (double) ? 1.0e-12 : 2.0e-5);
+    const SampleType offlineTolerance = verificationCase.scheduling == FrameScheduling::amortized ? tolerance : 0;
+
+    for (int ch = 0; ch < verificationCase.numOutputChannels; ++ch)
+        for (int n = 0; n + latency < numSamples; ++n)
+            if (std::abs (offlineOutput.getSample (ch, n) - output.getSample (ch, n + latency)) > offlineTolerance)
+                return "offline output differs (channel " + String (ch) + ", sample " + String (n) + ")";
+
+    // the first frame starts with the first sample, so the first fftSize samples don't get all overlapping frames
+    for (int ch = 0; ch < verificationCase.numOutputChannels; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+        {
+            const int inputSample = n - latency;
+            SampleType expected = 0;
+
+            if (inputSample >= 0 && inputSample < fftSize)
+                continue;
+
+            if (inputSample >= 0 && ch < verificationCase.numInputChannels)
+                expected = input.getSample (ch, inputSample);
+
+            if (std::abs (output.getSample (ch, n) - expected) > tolerance)
+                return "no perfect reconstruction (channel " + String (ch) + ", sample " + String (n) + ")";
+        }
+
+    return {};
+}
+
+/**
+ Activity detection with many channels of small transforms, which are transformed in batches: every other channel is
+ silent, so only the others may be transformed. Checks the reconstruction, and with statistics the number of transforms.
+ */
+template <typename SampleType>
+static String verifyBatchedActivity (const FrameDomain domain)
+{
+    const Resolution resolution { 256, 64 };
+    const int numChannels = 48;
+    const int numSamples = 8 * resolution.fftSize;
+    const int blockSize = 100;
+
+    BasicOverlappingFFTProcessor<SampleType> processor (resolution);
+    processor.setFrameDomain (domain);
+    processor.setActivityDetection (ActivityDetection::peak);
+    processor.prepare (48000.0, blockSize, numChannels, numChannels);
+    const int latency = processor.getLatencyInSamples();
+
+    Random random (3);
+    AudioBuffer<SampleType> input (numChannels, numSamples);
+    input.clear();
+    for (int ch = 0; ch < numChannels; ch += 2)
+        for (int n = 0; n < numSamples; ++n)
+            input.setSample (ch, n, (SampleType) (2.0 * random.nextDouble() - 1.0));
+
+    AudioBuffer<SampleType> output (input);
+    dsp::AudioBlock<SampleType> block (output);
+    for (int position = 0; position < numSamples; position += blockSize)
+    {
+        auto subBlock = block.getSubBlock ((size_t) position, (size_t) jmin (blockSize, numSamples - position));
+        processor.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+    }
+
+    const SampleType tolerance = (SampleType) (sizeof (SampleType) == sizeof (double) ? 1.0e-12 : 2.0e-5);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = latency + resolution.fftSize; n < numSamples; ++n)
+            if (std::abs (output.getSample (ch, n) - input.getSample (ch, n - latency)) > tolerance)
+                return "no perfect reconstruction (channel " + String (ch) + ", sample " + String (n) + ")";
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    // in matrix domain, all outputs are transformed back, as they are mixtures of the inputs
+    const int numFrames = (numSamples - resolution.fftSize) / resolution.hopSize + 1;
+    const int numActiveChannels = numChannels / 2;
+    const auto expectedNumTransforms = (uint64) numFrames * (uint64) (numActiveChannels + (domain == FrameDomain::matrix ? numChannels : numActiveChannels));
+    const auto numTransforms = processor.getStatistics().getNumTransforms();
+
+    if (numTransforms != expectedNumTransforms)
+        return String (numTransforms) + " transforms instead of " + String (expectedNumTransforms);
+   #endif
+
+    return {};
+}
+
+/** Records the snapshot of a frame parameter of each frame. */
+class FrameParameterRecorder : public OverlappingFFTProcessor
+{
+public:
+    FrameParameterRecorder (const int maximumNumEventsPerBlock) : OverlappingFFTProcessor (Resolution { 1024, 256 })
+    {
+        setNumFrameParameters (1, maximumNumEventsPerBlock, 100);
+    }
+
+    std::vector<float> snapshots;
+
+private:
+    void processFrameInBuffer (const int maxNumChannels) override
+    {
+        ignoreUnused (maxNumChannels);
+        snapshots.push_back (getFrameParameter (0));
+    }
+};
+
+/**
+ Frame parameter events every 64 samples, added to the blocks (cycling through the given sizes) which contain them.
+ With blocks of 64 samples, each event is at the last sample of its block. Returns the snapshots of the frames.
+ */
+static std::vector<float> recordFrameParameterEvents (const Array<int>& blockSizes)
+{
+    const int eventInterval = 64;
+    int maximumBlockSize = 1;
+    for (auto blockSize : blockSizes)
+        maximumBlockSize = jmax (maximumBlockSize, blockSize);
+
+    FrameParameterRecorder processor (maximumBlockSize / eventInterval + 1);
+    processor.prepare (48000.0, maximumBlockSize, 1, 1);
+
+    AudioBuffer<float> buffer (1, maximumBlockSize);
+    buffer.clear();
+    dsp::AudioBlock<float> block (buffer);
+
+    const int numSamples = 20000;
+    for (int position = 0, i = 0; position < numSamples; ++i)
+    {
+        const int blockSize = jmin (blockSizes[i % blockSizes.size()], numSamples - position);
+
+        for (int event = position + eventInterval - 1 - position % eventInterval; event < position + blockSize; event += eventInterval)
+            processor.addFrameParameterEvent (0, (float) ((event * 7) % 31), event - position);
+
+        auto subBlock = block.getSubBlock (0, (size_t) blockSize);
+        processor.process (dsp::ProcessContextReplacing<float> (subBlock));
+        position += blockSize;
+    }
+
+    return processor.snapshots;
+}
+
+/** The snapshots of frame parameter events must not depend on the host's block sizes, also with events at the last sample of the blocks. */
+static String verifyFrameParameterEvents()
+{
+    const auto snapshots = recordFrameParameterEvents ({ 64 });
+
+    if (std::adjacent_find (snapshots.begin(), snapshots.end(), std::not_equal_to<float>()) == snapshots.end())
+        return "the events don't change the snapshots";
+
+    for (auto& blockSizes : { Array<int> { 128 }, Array<int> { 32, 96 }, Array<int> { 1, 63, 200, 7, 512 } })
+        if (recordFrameParameterEvents (blockSizes) != snapshots)
+            return "the snapshots depend on the block sizes " + String (blockSizes[0]) + (blockSizes.size() > 1 ? ", ..." : "");
+
+    return {};
+}
+
+/** Leaves the frames unaltered, and remembers the fftSize of the last frame. */
+template <typename SampleType>
+class ResolutionRecorder : public BasicOverlappingFFTProcessor<SampleType>
+{
+public:
+    ResolutionRecorder (const Resolution resolution) : BasicOverlappingFFTProcessor<SampleType> (resolution) {}
+
+    ~ResolutionRecorder() { this->releaseResources(); }
+
+    std::atomic<int> lastFftSize { 0 };
+
+private:
+    void processFrame (const int channel, SampleType* data) override
+    {
+        ignoreUnused (channel, data);
+        lastFftSize = this->fftSize;
+    }
+
+    void processSpectrumInBuffer (const int maxNumChannels) override
+    {
+        ignoreUnused (maxNumChannels);
+        lastFftSize = this->fftSize;
+    }
+};
+
+/**
+ Changes the resolution while processing: as both resolutions reconstruct the input, the crossfades between them
+ have to reconstruct it as well, with the latency of the maximum fftSize. `process()` must not allocate, also not
+ when it picks up a new resolution (count the allocations of HeapBlock & co. with BENCHMARK_WRAP_MALLOC=1).
+ */
+template <typename SampleType>
+static String verifyResolutionChanges (const FrameDomain domain, const FrameScheduling scheduling)
+{
+    const int numChannels = 2;
+    const int numSamples = 90000;
+    const int maximumBlockSize = 512;
+    const Resolution changes[] { { 2048, 512 }, { 512, 128 }, { 1024, 256 }, { 512, 256 }, { 2048, 1024 }, { 960, 320 } };
+
+    ResolutionRecorder<SampleType> processor ({ 1024, 256 });
+    processor.setFrameDomain (domain);
+    processor.setFrameScheduling (scheduling);
+    processor.setNumWorkerThreads (scheduling == FrameScheduling::background ? 2 : 0);
+    processor.prepare (48000.0, maximumBlockSize, numChannels, numChannels, 2048, 1024);
+    const int latency = processor.getLatencyInSamples();
+
+    Random random (5);
+    AudioBuffer<SampleType> input (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            input.setSample (ch, n, (SampleType) (2.0 * random.nextDouble() - 1.0));
+
+    AudioBuffer<SampleType> output (input);
+    dsp::AudioBlock<SampleType> block (output);
+    int numChanges = 0;
+
+    for (int position = 0; position < numSamples;)
+    {
+        // the changes follow each other closely, so some of them are queued during a crossfade
+        if (numChanges < numElementsInArray (changes) && position >= 10000 + 7000 * numChanges)
+        {
+            const auto& resolution = changes[numChanges++];
+            if (! processor.setResolution (resolution.fftSize, resolution.hopSize))
+                return "the resolution " + String (resolution.fftSize) + " / " + String (resolution.hopSize) + " can't be used";
+        }
+
+        const int blockSize = jmin (random.nextInt (maximumBlockSize + 1), numSamples - position);
+        auto subBlock = block.getSubBlock ((size_t) position, (size_t) blockSize);
+
+        const auto allocationsBefore = numAllocations.load (std::memory_order_relaxed);
+        processor.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+
+        if (numAllocations.load (std::memory_order_relaxed) != allocationsBefore)
+            return "process() allocated at sample " + String (position);
+
+        if (processor.getLatencyInSamples() != latency)
+            return "the latency changed from " + String (latency) + " to " + String (processor.getLatencyInSamples());
+
+        position += blockSize;
+    }
+
+    if (processor.lastFftSize != changes[numChanges - 1].fftSize)
+        return "the last frame has the fftSize " + String (processor.lastFftSize.load()) + " instead of " + String (changes[numChanges - 1].fftSize);
+
+    const SampleType tolerance = (SampleType) (sizeof (SampleType) == sizeof (double) ? 1.0e-12 : 2.0e-5);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = latency + 2048; n < numSamples; ++n)
+            if (std::abs (output.getSample (ch, n) - input.getSample (ch, n - latency)) > tolerance)
+                return "no perfect reconstruction across the crossfades (channel " + String (ch) + ", sample " + String (n) + ")";
+
+    return {};
+}
+
+/**
+ Publishes the spectra of a sine wave at the centre of a bin (on the second channel, the first one is silent) to a
+ SpectrumTap, which is read after each block, but not for a while in the middle, so the queue overflows. All frames
+ have to be either read in order or counted as dropped, and a sine with amplitude 1 has to peak at about 1, in its
+ bin (without bands) or in the band around its frequency.
+ */
+template <typename SampleType>
+static String verifySpectrumTap (const FrameDomain domain, const FrameScheduling scheduling, const int numBands)
+{
+    const Resolution resolution { 1024, 256 };
+    const int numChannels = 2;
+    const int numSamples = 64 * resolution.hopSize + resolution.fftSize;
+    const int blockSize = 200;
+    const double sampleRate = 48000.0;
+    const int sineBin = 64;
+    const double sineFrequency = sineBin * sampleRate / resolution.fftSize;
+
+    SpectrumTap tap (resolution.fftSize, numBands, 8, 1);
+    BenchmarkProcessor<SampleType> processor (resolution, domain, scheduling);
+    processor.setSpectrumTap (&tap);
+    processor.prepare (sampleRate, blockSize, numChannels, numChannels);
+
+    AudioBuffer<SampleType> buffer (numChannels, numSamples);
+    buffer.clear();
+    for (int n = 0; n < numSamples; ++n)
+        buffer.setSample (1, n, (SampleType) std::sin (MathConstants<double>::twoPi * sineFrequency * n / sampleRate));
+
+    dsp::AudioBlock<SampleType> block (buffer);
+    int64 nextPosition = 0;
+    int numFramesRead = 0;
+    String error;
+
+    auto readFrame = [&] (const SpectrumTap::Frame& frame)
+    {
+        ++numFramesRead;
+
+        // after frames were dropped, the positions skip some hops
+        if (frame.position % resolution.hopSize != 0)
+            error = "frame at position " + String (frame.position) + ", which isn't at a hop";
+        else if (frame.position < nextPosition)
+            error = "frame at position " + String (frame.position) + " after the frame at " + String (nextPosition - resolution.hopSize);
+
+        nextPosition = frame.position + resolution.hopSize;
+
+        const int expectedNumValues = numBands > 0 ? numBands : resolution.fftSize / 2 + 1;
+        if (frame.fftSize != resolution.fftSize || frame.numValues != expectedNumValues)
+            error = "frame with fftSize " + String (frame.fftSize) + " and " + String (frame.numValues) + " values";
+
+        const auto peak = std::max_element (frame.values, frame.values + frame.numValues);
+        const int peakIndex = (int) (peak - frame.values);
+
+        if (std::abs (*peak - 1.0f) > 0.05f)
+            error = "the sine peaks at " + String (*peak);
+
+        if (numBands == 0)
+        {
+            if (peakIndex != sineBin)
+                error = "the sine peaks in bin " + String (peakIndex) + " instead of " + String (sineBin);
+
+            // beyond the main lobe of the Hann window, there's hardly anything left
+            for (int bin = 0; bin < frame.numValues; ++bin)
+                if (std::abs (bin - sineBin) > 1 && frame.values[bin] > 1.0e-3f)
+                    error = "bin " + String (bin) + " has the magnitude " + String (frame.values[bin]);
+        }
+        else if (std::abs (std::log (tap.getFrequency (peakIndex, frame.fftSize) / sineFrequency)) > std::log (1000.0) / numBands)
+        {
+            error = "the sine peaks in the band around " + String (tap.getFrequency (peakIndex, frame.fftSize)) + " Hz";
+        }
+    };
+
+    for (int position = 0; position < numSamples; position += blockSize)
+    {
+        auto subBlock = block.getSubBlock ((size_t) position, (size_t) jmin (blockSize, numSamples - position));
+        processor.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+
+        if (position < numSamples / 3 || position > numSamples / 2)
+            tap.readFrames (readFrame);
+
+        if (error.isNotEmpty())
+            return error;
+    }
+
+    processor.releaseResources();
+    tap.readFrames (readFrame);
+
+    if (error.isNotEmpty())
+        return error;
+
+    // with deferred scheduling, the last frame might still have been waiting for its deferral
+    const int numFrames = (numSamples - resolution.fftSize) / resolution.hopSize + 1;
+    const int numPublishedFrames = numFramesRead + (int) tap.getNumDroppedFrames();
+    if (tap.getNumDroppedFrames() == 0 || numPublishedFrames > numFrames
+        || numPublishedFrames < numFrames - (scheduling == FrameScheduling::synchronous ? 0 : 1))
+        return String (numFramesRead) + " frames read and " + String (tap.getNumDroppedFrames()) + " dropped, out of " + String (numFrames);
+
+    return {};
+}
+
+/** Direct convolution of a channel of the input with the impulse response (its last channel, if it has fewer), at input sample n. */
+template <typename SampleType>
+static double convolveDirectly (const AudioBuffer<SampleType>& input, const AudioBuffer<SampleType>& impulseResponse, const int channel, const int n)
+{
+    const int irChannel = jmin (channel, impulseResponse.getNumChannels() - 1);
+    double sum = 0.0;
+
+    for (int i = 0; i < impulseResponse.getNumSamples() && i <= n; ++i)
+        sum += (double) impulseResponse.getSample (irChannel, i) * (double) input.getSample (channel, n - i);
+
+    return sum;
+}
+
+/** Decaying noise as impulse response. */
+template <typename SampleType>
+static AudioBuffer<SampleType> createImpulseResponse (const int numChannels, const int length, Random& random)
+{
+    AudioBuffer<SampleType> impulseResponse (numChannels, length);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = 0; n < length; ++n)
+            impulseResponse.setSample (ch, n, (SampleType) (0.1 * (2.0 * random.nextDouble() - 1.0) * std::exp (-3.0 * n / length)));
+
+    return impulseResponse;
+}
+
+/**
+ Convolves noise with a uniformly or non-uniformly partitioned convolution, with varying block sizes, and loads another
+ impulse response in the middle. The output has to be the direct convolution from the first sample on, with the first
+ impulse response before the swap, and with the second one after the crossfade.
+ */
+template <typename SampleType, typename Convolution>
+static String verifyConvolution (Convolution& convolution, const int expectedLatency, const int crossfadeLength)
+{
+    const int numChannels = 2;
+    const int numSamples = 16000;
+    const int swapPosition = 8000;
+    const int maximumBlockSize = 512;
+
+    Random random (5);
+    const auto first = createImpulseResponse<SampleType> (numChannels, 3000, random);
+    const auto second = createImpulseResponse<SampleType> (1, 2000, random); // mono, for all channels
+
+    AudioBuffer<SampleType> input (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            input.setSample (ch, n, (SampleType) (2.0 * random.nextDouble() - 1.0));
+
+    convolution.loadImpulseResponse (first);
+    convolution.prepare (48000.0, maximumBlockSize, numChannels, numChannels);
+
+    const int latency = convolution.getLatencyInSamples();
+    if (latency != expectedLatency)
+        return "latency is " + String (latency) + " instead of " + String (expectedLatency);
+
+    AudioBuffer<SampleType> output (input);
+    dsp::AudioBlock<SampleType> block (output);
+
+    for (int position = 0; position < numSamples;)
+    {
+        if (position == swapPosition)
+            convolution.loadImpulseResponse (second);
+
+        const int end = position < swapPosition ? swapPosition : numSamples;
+        const int blockSize = jmin (random.nextInt (maximumBlockSize + 1), end - position);
+        auto subBlock = block.getSubBlock ((size_t) position, (size_t) blockSize);
+        convolution.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+        position += blockSize;
+    }
+
+    const double tolerance = sizeof (SampleType) == sizeof (double) ? 1.0e-10 : 5.0e-5;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+        {
+            if (n >= swapPosition && n < swapPosition + crossfadeLength)
+                continue;
+
+            const auto& impulseResponse = n < swapPosition ? first : second;
+            const double expected = n < latency ? 0.0 : convolveDirectly (input, impulseResponse, ch, n - latency);
+
+            if (std::abs ((double) output.getSample (ch, n) - expected) > tolerance)
+                return "output differs from the direct convolution (channel " + String (ch) + ", sample " + String (n) + ")";
+        }
+
+    return {};
+}
+
+/** The uniformly and non-uniformly partitioned convolutions, with latency and without. */
+template <typename SampleType>
+static String verifyConvolutions()
+{
+    for (int latency : { -1, 0 })
+        for (int numWorkerThreads : { 0, 2 })
+        {
+            BasicUniformPartitionedConvolution<SampleType> convolution (256, 3000, latency);
+            convolution.setNumWorkerThreads (numWorkerThreads);
+
+            // the new impulse response is picked up with the next frame, and crossfaded within one partition
+            const auto error = verifyConvolution<SampleType> (convolution, latency < 0 ? 255 : latency, 2 * 256);
+            if (error.isNotEmpty())
+                return "uniform, latency " + String (latency) + ", " + String (numWorkerThreads) + " worker threads: " + error;
+        }
+
+    for (bool zeroLatency : { false, true })
+    {
+        BasicPartitionedConvolution<SampleType> convolution ({ 64, 256, 1024 }, 3000, zeroLatency);
+
+        // each segment crossfades with its own partition size, the largest one takes the longest
+        const auto error = verifyConvolution<SampleType> (convolution, zeroLatency ? 0 : 63, 2 * 1024);
+        if (error.isNotEmpty())
+            return String ("non-uniform, ") + (zeroLatency ? "zero latency: " : "latency 63: ") + error;
+    }
+
+    return {};
+}
+
+/** Runs noise through a multi-resolution processor with unaltered stages, with varying block sizes. */
+template <typename SampleType>
+static AudioBuffer<SampleType> processMultiResolution (const AudioBuffer<SampleType>& input, const int numWorkerThreads, int& latency)
+{
+    const int maximumBlockSize = 512;
+    BasicMultiResolutionFFTProcessor<SampleType> processor ({ { 4096, 1024 }, { 1024, 256 }, { 256, 64 } }, { 300.0, 2500.0 });
+    processor.setNumWorkerThreads (numWorkerThreads);
+    processor.prepare (48000.0, maximumBlockSize, input.getNumChannels(), input.getNumChannels());
+    latency = processor.getLatencyInSamples();
+
+    AudioBuffer<SampleType> output (input);
+    dsp::AudioBlock<SampleType> block (output);
+    Random random (11);
+
+    for (int position = 0; position < output.getNumSamples();)
+    {
+        const int blockSize = jmin (random.nextInt (maximumBlockSize + 1), output.getNumSamples() - position);
+        auto subBlock = block.getSubBlock ((size_t) position, (size_t) blockSize);
+        processor.process (dsp::ProcessContextReplacing<SampleType> (subBlock));
+        position += blockSize;
+    }
+
+    return output;
+}
+
+/**
+ The band gains of the stages sum up to 1, so the sum of the bands reconstructs white noise with errors below -45 dB
+ (see the class description), once the frames of the largest stage overlap. With worker threads, the frames of the
+ stages are written back in the same order, so the output has to be the same.
+ */
+template <typename SampleType>
+static String verifyMultiResolution()
+{
+    const int numChannels = 2;
+    const int numSamples = 16 * 4096;
+
+    Random random (13);
+    AudioBuffer<SampleType> input (numChannels, numSamples);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = 0; n < numSamples; ++n)
+            input.setSample (ch, n, (SampleType) (2.0 * random.nextDouble() - 1.0));
+
+    int latency = 0, latencyWithWorkers = 0;
+    const auto output = processMultiResolution (input, 0, latency);
+    const auto outputWithWorkers = processMultiResolution (input, 2, latencyWithWorkers);
+
+    if (latency != 4095 || latencyWithWorkers != latency)
+        return "latency is " + String (latency) + " instead of 4095";
+
+    double signalEnergy = 0.0, errorEnergy = 0.0;
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int n = latency + 4096; n < numSamples; ++n)
+        {
+            if (output.getSample (ch, n) != outputWithWorkers.getSample (ch, n))
+                return "output depends on the worker threads (channel " + String (ch) + ", sample " + String (n) + ")";
+
+            const double expected = input.getSample (ch, n - latency);
+            signalEnergy += expected * expected;
+            errorEnergy += square (output.getSample (ch, n) - expected);
+        }
+
+    const double errorInDecibels = Decibels::gainToDecibels (std::sqrt (errorEnergy / signalEnergy), -200.0);
+    if (errorInDecibels > -45.0)
+        return "the bands don't sum up to the input, the error is " + String (errorInDecibels, 1) + " dB";
+
+    return {};
+}
+
+/**
+ Verifies all combinations of a set of resolutions, frame domains, frame schedulings and channel counts, in both precisions,
+ with the default windows and with low-delay windows.
+ */
+static bool verifyAll()
+{
+    const Resolution resolutions[] { { 64, 32 }, { 256, 64 }, { 1024, 256 }, { 960, 320 }, { 2048, 1024 } };
+    const std::pair<FrameDomain, FrameScheduling> modes[] { { FrameDomain::time, FrameScheduling::synchronous },
+                                                            { FrameDomain::time, FrameScheduling::background },
+                                                            { FrameDomain::frequency, FrameScheduling::synchronous },
+                                                            { FrameDomain::frequency, FrameScheduling::background },
+                                                            { FrameDomain::frequency, FrameScheduling::amortized },
+                                                            { FrameDomain::splitComplex, FrameScheduling::synchronous },
+                                                            { FrameDomain::splitComplex, FrameScheduling::background },
+                                                            { FrameDomain::splitComplex, FrameScheduling::amortized },
+                                                            { FrameDomain::matrix, FrameScheduling::synchronous },
+                                                            { FrameDomain::matrix, FrameScheduling::background },
+                                                            { FrameDomain::matrix, FrameScheduling::amortized } };
+    const std::pair<int, int> channelCounts[] { { 1, 1 }, { 2, 2 }, { 1, 3 }, { 3, 1 }, { 16, 16 } };
+
+    int numFailed = 0, numCases = 0;
+
+    for (bool useDoublePrecision : { false, true })
+        for (auto& resolution : resolutions)
+            for (auto& mode : modes)
+                for (auto& channels : channelCounts)
+                    for (int numWorkerThreads : { 0, 2 })
+                        for (int synthesisWindowLength : { 0, 2 * resolution.hopSize })
+                        {
+                            const VerificationCase verificationCase { resolution, mode.first, mode.second, channels.first, channels.second,
+                                                                      numWorkerThreads, synthesisWindowLength };
+                            const auto error = useDoublePrecision ? verify<double> (verificationCase) : verify<float> (verificationCase);
+                            ++numCases;
+
+                            if (error.isNotEmpty())
+                            {
+                                ++numFailed;
+                                std::cerr << "FAILED: " << (useDoublePrecision ? "double" : "float")
+                                          << ", fftSize " << resolution.fftSize << ", hopSize " << resolution.hopSize
+                                          << ", " << getName (mode.first) << ", " << getName (mode.second)
+                                          << ", " << channels.first << " in, " << channels.second << " out, "
+                                          << numWorkerThreads << " worker threads, synthesis window " << synthesisWindowLength
+                                          << ": " << error << std::endl;
+                            }
+                        }
+
+    for (bool useDoublePrecision : { false, true })
+        for (auto domain : { FrameDomain::frequency, FrameDomain::splitComplex, FrameDomain::matrix })
+        {
+            const auto error = useDoublePrecision ? verifyBatchedActivity<double> (domain) : verifyBatchedActivity<float> (domain);
+            ++numCases;
+
+            if (error.isNotEmpty())
+            {
+                ++numFailed;
+                std::cerr << "FAILED: " << (useDoublePrecision ? "double" : "float") << ", batched transforms with activity detection, "
+                          << getName (domain) << ": " << error << std::endl;
+            }
+        }
+
+    auto check = [&numFailed, &numCases] (const String& name, const String& error)
+    {
+        ++numCases;
+
+        if (error.isNotEmpty())
+        {
+            ++numFailed;
+            std::cerr << "FAILED: " << name << ": " << error << std::endl;
+        }
+    };
+
+    check ("frame parameter events", verifyFrameParameterEvents());
+
+    for (bool useDoublePrecision : { false, true })
+        for (auto& mode : { std::make_pair (FrameDomain::time, FrameScheduling::synchronous),
+                            std::make_pair (FrameDomain::time, FrameScheduling::background),
+                            std::make_pair (FrameDomain::frequency, FrameScheduling::amortized) })
+            check (String (useDoublePrecision ? "double" : "float") + ", resolution changes, " + getName (mode.first) + ", " + getName (mode.second),
+                   useDoublePrecision ? verifyResolutionChanges<double> (mode.first, mode.second) : verifyResolutionChanges<float> (mode.first, mode.second));
+
+    for (bool useDoublePrecision : { false, true })
+        for (auto& mode : { std::make_pair (FrameDomain::time, FrameScheduling::synchronous),
+                            std::make_pair (FrameDomain::frequency, FrameScheduling::background),
+                            std::make_pair (FrameDomain::splitComplex, FrameScheduling::amortized),
+                            std::make_pair (FrameDomain::matrix, FrameScheduling::synchronous) })
+            for (int numBands : { 0, 32 })
+                check (String (useDoublePrecision ? "double" : "float") + ", spectrum tap with " + String (numBands) + " bands, "
+                           + getName (mode.first) + ", " + getName (mode.second),
+                       useDoublePrecision ? verifySpectrumTap<double> (mode.first, mode.second, numBands)
+                                          : verifySpectrumTap<float> (mode.first, mode.second, numBands));
+
+    check ("float, partitioned convolution", verifyConvolutions<float>());
+    check ("double, partitioned convolution", verifyConvolutions<double>());
+    check ("float, multi-resolution band sum", verifyMultiResolution<float>());
+    check ("double, multi-resolution band sum", verifyMultiResolution<double>());
+
+    std::cerr << numCases - numFailed << " of " << numCases << " cases passed" << std::endl;
+    return numFailed == 0;
+}
+
+//==============================================================================
+static void printUsage()
+{
+    std::cout << "Usage: OverlappingFFTProcessorBenchmark [options]" << std::endl
+              << "  --verify                   checks reconstruction, latency, block size independence and offline rendering instead" << std::endl
+              << "  --output <file>            writes the JSON results to a file instead of stdout" << std::endl
+              << "  --quick                    small grid with short runs, e.g. as smoke test" << std::endl
+              << "  --seconds <s>              audio processed per case (default: 2)" << std::endl
+              << "  --fft-sizes <a,b,...>      default: 256,1024,4096" << std::endl
+              << "  --hop-dividers <a,b,...>   hopSize = fftSize / divider, default: 2,4" << std::endl
+              << "  --block-sizes <a,b,...>    default: 1,31,64,256,1023" << std::endl
+              << "  --channels <a,b,...>       default: 1,2,16,64" << std::endl
+              << "  --domain <d>               time, frequency (default), splitComplex or matrix" << std::endl
+              << "  --scheduling <s>           synchronous (default), background or amortized" << std::endl
+              << "  --threads <n>              number of worker threads (default: 0)" << std::endl
+              << "  --sample-type <t>          float (default) or double" << std::endl;
+}
+
+static Array<int> parseList (const String& text)
+{
+    Array<int> values;
+
+    for (auto& token : StringArray::fromTokens (text, ",", ""))
+        if (token.getIntValue() > 0)
+            values.add (token.getIntValue());
+
+    return values;
+}
+
+/** Returns false if the arguments can't be used. */
+static bool parseArguments (const StringArray& args, Settings& settings)
+{
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        const auto value = args[i + 1];
+
+        if (arg == "--quick")
+        {
+            settings.fftSizes = { 1024 };
+            settings.hopSizeDividers = { 4 };
+            settings.blockSizes = { 1, 31, 1023 };
+            settings.channelCounts = { 2, 16 };
+            settings.secondsPerCase = 0.5;
+            continue;
+        }
+
+        if (arg == "--output")                settings.outputFile = value;
+        else if (arg == "--seconds")          settings.secondsPerCase = value.getDoubleValue();
+        else if (arg == "--fft-sizes")        settings.fftSizes = parseList (value);
+        else if (arg == "--hop-dividers")     settings.hopSizeDividers = parseList (value);
+        else if (arg == "--block-sizes")      settings.blockSizes = parseList (value);
+        else if (arg == "--channels")         settings.channelCounts = parseList (value);
+        else if (arg == "--threads")          settings.numWorkerThreads = value.getIntValue();
+        else if (arg == "--domain")
+        {
+            if (value == "time")                    settings.domain = FrameDomain::time;
+            else if (value == "frequency")          settings.domain = FrameDomain::frequency;
+            else if (value == "splitComplex")       settings.domain = FrameDomain::splitComplex;
+            else if (value == "matrix")             settings.domain = FrameDomain::matrix;
+            else return false;
+        }
+        else if (arg == "--sample-type")
+        {
+            if (value == "float")                   settings.useDoublePrecision = false;
+            else if (value == "double")             settings.useDoublePrecision = true;
+            else return false;
+        }
+        else if (arg == "--scheduling")
+        {
+            if (value == "synchronous")             settings.scheduling = FrameScheduling::synchronous;
+            else if (value == "background")         settings.scheduling = FrameScheduling::background;
+            else if (value == "amortized")          settings.scheduling = FrameScheduling::amortized;
+            else return false;
+        }
+        else
+        {
+            return false;
+        }
+
+        ++i;
+    }
+
+    // amortized scheduling needs the processor to do the transforms
+    if (settings.scheduling == FrameScheduling::amortized
+        && settings.domain == FrameDomain::time)
+        return false;
+
+    return settings.secondsPerCase > 0.0 && settings.numWorkerThreads >= 0
+        && ! settings.fftSizes.isEmpty() && ! settings.hopSizeDividers.isEmpty()
+        && ! settings.blockSizes.isEmpty() && ! settings.channelCounts.isEmpty();
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    StringArray args;
+    for (int i = 1; i < argc; ++i)
+        args.add (argv[i]);
+
+    if (args.contains ("--verify"))
+        return verifyAll() ? 0 : 1;
+
+    Settings settings;
+
+    if (args.contains ("--help") || ! parseArguments (args, settings))
+    {
+        printUsage();
+        return args.contains ("--help") ? 0 : 1;
+    }
+
+    Array<var> results;
+
+    for (auto fftSize : settings.fftSizes)
+        for (auto hopSizeDivider : settings.hopSizeDividers)
+            for (auto blockSize : settings.blockSizes)
+                for (auto numChannels : settings.channelCounts)
+                {
+                    if (hopSizeDivider > fftSize)
+                        continue;
+
+                    const BenchmarkCase benchmarkCase { fftSize, hopSizeDivider, blockSize, numChannels };
+                    const auto result = settings.useDoublePrecision ? runCase<double> (benchmarkCase, settings)
+                                                                    : runCase<float> (benchmarkCase, settings);
+
+                    std::cerr << "fftSize " << String (fftSize).paddedLeft (' ', 5)
+                              << "  hop 1/" << hopSizeDivider
+                              << "  block " << String (blockSize).paddedLeft (' ', 4)
+                              << "  channels " << String (numChannels).paddedLeft (' ', 3)
+                              << "  | " << String (result.nsPerSample, 1).paddedLeft (' ', 9) << " ns/sample"
+                              << "  worst " << String (result.worstCallbackNs / 1000.0, 1).paddedLeft (' ', 8) << " us"
+                              << "  " << String (result.allocationsPerCallback, 3) << " allocs/callback" << std::endl;
+
+                    results.add (toJSON (benchmarkCase, result));
+                }
+
+    DynamicObject::Ptr report (new DynamicObject());
+    report->setProperty ("environment", getEnvironment (settings));
+    report->setProperty ("results", results);
+
+    const auto json = JSON::toString (var (report.get()));
+
+    if (settings.outputFile.isEmpty())
+        std::cout << json << std::endl;
+    else if (! File::getCurrentWorkingDirectory().getChildFile (settings.outputFile).replaceWithText (json))
+    {
+        std::cerr << "Couldn't write " << settings.outputFile << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
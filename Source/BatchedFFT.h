@@ -0,0 +1,273 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "FFTBackend.h"
+#include "SplitComplexBuffer.h"
+
+/**
+ Real-only FFT (power of 2 sizes) which transforms several channels at once: each lane of a
+ dsp::SIMDRegister holds another channel (4 with SSE and NEON, 8 with AVX). So even small transforms,
+ which can't make use of SIMD registers within a single channel, run fully vectorized.
+
+ Input and output have the same layout as FFTBackend::performRealOnlyForwardTransform (data, true)
+ and FFTBackend::performRealOnlyInverseTransform(). The perform methods can be called from several threads at once,
+ threads which pass their own workspace (see `createWorkspace()`) don't compete for the shared scratch memory.
+ With SampleType double, a register holds half as many channels.
+ */
+template <typename SampleType>
+class BatchedRealFFT
+{
+public:
+    using Register = dsp::SIMDRegister<SampleType>;
+    static constexpr int numLanes = (int) Register::SIMDNumElements;
+
+    /** Constructor
+     @param fftSize number of samples of the transform, a power of 2 and at least 4
+     */
+    BatchedRealFFT (const int fftSize)
+    : size (fftSize), halfSize (fftSize / 2),
+      scratch ([this] { return new SplitComplexBuffer<SampleType> (1, halfSize * numLanes); })
+    {
+        jassert (isPowerOfTwo (size) && size >= 4);
+
+        // the real transform of size N is done with a complex transform of size N / 2
+        int numBits = 0;
+        while ((1 << numBits) < halfSize)
+            ++numBits;
+
+        bitReversed.malloc ((size_t) halfSize);
+        for (int i = 0; i < halfSize; ++i)
+        {
+            int reversed = 0;
+            for (int bit = 0; bit < numBits; ++bit)
+                reversed |= ((i >> bit) & 1) << (numBits - 1 - bit);
+
+            bitReversed[i] = reversed;
+        }
+
+        // twiddles exp (-2 pi i k / N) for k in [0, N / 2], the even ones are those of the complex transform
+        twiddleRe.malloc ((size_t) halfSize + 1);
+        twiddleIm.malloc ((size_t) halfSize + 1);
+        for (int k = 0; k <= halfSize; ++k)
+        {
+            const double phase = -2.0 * MathConstants<double>::pi * k / size;
+            twiddleRe[k] = (SampleType) std::cos (phase);
+            twiddleIm[k] = (SampleType) std::sin (phase);
+        }
+    }
+
+    int getSize() const noexcept { return size; }
+
+    /** Creates the scratch memory for the transforms of one thread, see FFTBackend::createWorkspace(). */
+    std::unique_ptr<FFTWorkspace> createWorkspace() const { return scratch.createWorkspace(); }
+
+    /**
+     Forward transforms of up to `numLanes` channels, each holding `getSize()` samples (and room for 2 * size values).
+     Only the non-negative frequencies are calculated.
+     */
+    void performRealOnlyForwardTransforms (SampleType* const* channels, const int numChannels, FFTWorkspace* workspace = nullptr) const noexcept
+    {
+        jassert (numChannels <= numLanes);
+        typename Scratch::ScopedSlot slot (scratch, workspace);
+        SampleType* re = slot->getRealPointer (0);
+        SampleType* im = slot->getImagPointer (0);
+
+        // z[n] = x[2n] + i x[2n + 1], stored in bit reversed order, one channel per lane
+        for (int n = 0; n < halfSize; ++n)
+        {
+            const int index = bitReversed[n] * numLanes;
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                re[index + lane] = lane < numChannels ? channels[lane][2 * n] : SampleType();
+                im[index + lane] = lane < numChannels ? channels[lane][2 * n + 1] : SampleType();
+            }
+        }
+
+        performComplexTransform (re, im, false);
+
+        // X[k] = E[k] + W^k O[k], with the spectra of the even and odd samples E[k] = (Z[k] + Z*[M - k]) / 2 and O[k] = (Z[k] - Z*[M - k]) / 2i
+        const auto half = Register::expand ((SampleType) 0.5);
+        alignas (64) SampleType resultRe[numLanes], resultIm[numLanes];
+
+        for (int k = 0; k <= halfSize; ++k)
+        {
+            const int index = (k % halfSize) * numLanes;
+            const int mirroredIndex = ((halfSize - k) % halfSize) * numLanes;
+
+            const auto zRe = Register::fromRawArray (re + index);
+            const auto zIm = Register::fromRawArray (im + index);
+            const auto mRe = Register::fromRawArray (re + mirroredIndex);
+            const auto mIm = Register::fromRawArray (im + mirroredIndex);
+
+            const auto evenRe = (zRe + mRe) * half;
+            const auto evenIm = (zIm - mIm) * half;
+            const auto oddRe = (zIm + mIm) * half;
+            const auto oddIm = (mRe - zRe) * half;
+
+            const auto wRe = Register::expand (twiddleRe[k]);
+            const auto wIm = Register::expand (twiddleIm[k]);
+
+            (evenRe + wRe * oddRe - wIm * oddIm).copyToRawArray (resultRe);
+            (evenIm + wRe * oddIm + wIm * oddRe).copyToRawArray (resultIm);
+
+            for (int lane = 0; lane < numChannels; ++lane)
+            {
+                channels[lane][2 * k] = resultRe[lane];
+                channels[lane][2 * k + 1] = resultIm[lane];
+            }
+        }
+    }
+
+    /** Inverse transforms of up to `numLanes` channels, only the non-negative frequencies are used. The result is scaled by 1 / size. */
+    void performRealOnlyInverseTransforms (SampleType* const* channels, const int numChannels, FFTWorkspace* workspace = nullptr) const noexcept
+    {
+        jassert (numChannels <= numLanes);
+        typename Scratch::ScopedSlot slot (scratch, workspace);
+        SampleType* re = slot->getRealPointer (0);
+        SampleType* im = slot->getImagPointer (0);
+
+        // Z[k] = E[k] + i O[k], with E[k] = (X[k] + X*[M - k]) / 2 and O[k] = (X[k] - X*[M - k]) W^-k / 2
+        const auto half = Register::expand ((SampleType) 0.5);
+        alignas (64) SampleType xRe[numLanes], xIm[numLanes], mirroredRe[numLanes], mirroredIm[numLanes];
+
+        for (int k = 0; k < halfSize; ++k)
+        {
+            for (int lane = 0; lane < numLanes; ++lane)
+            {
+                const bool isUsed = lane < numChannels;
+                xRe[lane] = isUsed ? channels[lane][2 * k] : SampleType();
+                xIm[lane] = isUsed ? channels[lane][2 * k + 1] : SampleType();
+                mirroredRe[lane] = isUsed ? channels[lane][2 * (halfSize - k)] : SampleType();
+                mirroredIm[lane] = isUsed ? channels[lane][2 * (halfSize - k) + 1] : SampleType();
+            }
+
+            const auto aRe = Register::fromRawArray (xRe);
+            const auto aIm = Register::fromRawArray (xIm);
+            const auto mRe = Register::fromRawArray (mirroredRe);
+            const auto mIm = Register::fromRawArray (mirroredIm);
+
+            const auto evenRe = (aRe + mRe) * half;
+            const auto evenIm = (aIm - mIm) * half;
+            const auto differenceRe = (aRe - mRe) * half;
+            const auto differenceIm = (aIm + mIm) * half;
+
+            const auto wRe = Register::expand (twiddleRe[k]);
+            const auto wIm = Register::expand (twiddleIm[k]);
+            const auto oddRe = differenceRe * wRe + differenceIm * wIm;
+            const auto oddIm = differenceIm * wRe - differenceRe * wIm;
+
+            const int index = bitReversed[k] * numLanes;
+            (evenRe - oddIm).copyToRawArray (re + index);
+            (evenIm + oddRe).copyToRawArray (im + index);
+        }
+
+        performComplexTransform (re, im, true);
+
+        // x[2n] = Re z[n], x[2n + 1] = Im z[n]
+        const SampleType scale = (SampleType) 1 / halfSize;
+        for (int n = 0; n < halfSize; ++n)
+            for (int lane = 0; lane < numChannels; ++lane)
+            {
+                channels[lane][2 * n] = scale * re[n * numLanes + lane];
+                channels[lane][2 * n + 1] = scale * im[n * numLanes + lane];
+            }
+    }
+
+private:
+    using Scratch = ConcurrentSlots<SplitComplexBuffer<SampleType>>;
+
+    /** Radix-2 decimation in time transform of size N / 2 on bit reversed input, unscaled. */
+    void performComplexTransform (SampleType* re, SampleType* im, const bool inverse) const noexcept
+    {
+        for (int length = 2; length <= halfSize; length <<= 1)
+        {
+            const int halfLength = length / 2;
+            const int twiddleStep = size / length;
+
+            for (int start = 0; start < halfSize; start += length)
+                for (int j = 0; j < halfLength; ++j)
+                {
+                    const auto wRe = Register::expand (twiddleRe[j * twiddleStep]);
+                    const auto wIm = Register::expand (inverse ? -twiddleIm[j * twiddleStep] : twiddleIm[j * twiddleStep]);
+
+                    SampleType* aRe = re + (start + j) * numLanes;
+                    SampleType* aIm = im + (start + j) * numLanes;
+                    SampleType* bRe = aRe + halfLength * numLanes;
+                    SampleType* bIm = aIm + halfLength * numLanes;
+
+                    const auto xRe = Register::fromRawArray (bRe);
+                    const auto xIm = Register::fromRawArray (bIm);
+                    const auto tRe = xRe * wRe - xIm * wIm;
+                    const auto tIm = xRe * wIm + xIm * wRe;
+
+                    const auto uRe = Register::fromRawArray (aRe);
+                    const auto uIm = Register::fromRawArray (aIm);
+
+                    (uRe + tRe).copyToRawArray (aRe);
+                    (uIm + tIm).copyToRawArray (aIm);
+                    (uRe - tRe).copyToRawArray (bRe);
+                    (uIm - tIm).copyToRawArray (bIm);
+                }
+        }
+    }
+
+    const int size;
+    const int halfSize;
+    HeapBlock<int> bitReversed;
+    HeapBlock<SampleType> twiddleRe, twiddleIm;
+    Scratch scratch;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchedRealFFT)
+};
+
+//==============================================================================
+/**
+ Process-wide cache of BatchedRealFFTs, use it with a SharedResourcePointer. Like the plans of the FFTPlanCache,
+ a transform (with its twiddles and scratch buffers) is shared by all processors with the same fftSize, as long as
+ one of them uses it.
+ */
+template <typename SampleType>
+class BatchedFFTCache
+{
+public:
+    BatchedFFTCache() {}
+
+    /** Returns the transform for the given size, and creates it if there's none yet. Don't call this from the audio thread. */
+    std::shared_ptr<const BatchedRealFFT<SampleType>> getTransform (const int fftSize)
+    {
+        const ScopedLock sl (lock);
+
+        auto& cachedTransform = transforms[fftSize];
+        if (auto transform = cachedTransform.lock())
+            return transform;
+
+        std::shared_ptr<const BatchedRealFFT<SampleType>> transform (new BatchedRealFFT<SampleType> (fftSize));
+        cachedTransform = transform;
+        return transform;
+    }
+
+private:
+    CriticalSection lock;
+    std::map<int, std::weak_ptr<const BatchedRealFFT<SampleType>>> transforms;
+
+    JUCE_DECLARE_NON_COPYABLE (BatchedFFTCache)
+};
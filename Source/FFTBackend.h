@@ -0,0 +1,826 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#include "SplitComplexBuffer.h"
+
+#ifndef OVERLAPPINGFFTPROCESSOR_USE_FFTW
+ /** Set this to 1 (and link against fftw3f, and fftw3 for double) to use FFTW plans (FFTW_MEASURE) for all sizes. */
+ #define OVERLAPPINGFFTPROCESSOR_USE_FFTW 0
+#endif
+
+#if OVERLAPPINGFFTPROCESSOR_USE_FFTW
+ #include <fftw3.h>
+#endif
+
+/**
+ Scratch memory which belongs to a single thread, e.g. one of the threads processing the frames of a processor.
+ It's created by `FFTBackend::createWorkspace()` and passed to the perform methods of the same backend, which
+ then don't need to grab any of their shared scratch memory.
+ */
+struct FFTWorkspace
+{
+    virtual ~FFTWorkspace() {}
+};
+
+/**
+ One object of type Slot for each concurrently running transform (e.g. a juce::dsp::FFT, whose engine might
+ use a work buffer, or scratch memory). Slots are grabbed without locking or allocating: a caller passes its own
+ workspace (see `createWorkspace()`), or uses one of the shared slots. Their number has to cover all threads which
+ might use them at the same time, if all of them are taken anyway, that's asserted and the caller waits for a slot to
+ be released. So threads which mustn't wait (e.g. the audio thread) pass a workspace.
+ */
+template <typename Slot>
+class ConcurrentSlots
+{
+public:
+    /** Constructor
+     @param createFunction returns a new Slot
+     @param numberOfSlots number of shared slots, i.e. the maximum number of threads using them at the same time
+     */
+    ConcurrentSlots (std::function<Slot*()> createFunction, const int numberOfSlots = 2)
+    : createSlot (std::move (createFunction)), numSlots (numberOfSlots)
+    {
+        jassert (numSlots > 0);
+
+        for (int i = 0; i < numSlots; ++i)
+            slots.add (createSlot());
+
+        inUse.reset (new std::atomic<bool>[(size_t) numSlots]);
+        for (int i = 0; i < numSlots; ++i)
+            inUse[i] = false;
+    }
+
+    int getNumSlots() const noexcept { return numSlots; }
+
+    /** Creates a slot, which is owned by the caller. */
+    std::unique_ptr<FFTWorkspace> createWorkspace() const
+    {
+        auto* workspace = new Workspace();
+        workspace->slot.reset (createSlot());
+        return std::unique_ptr<FFTWorkspace> (workspace);
+    }
+
+    /**
+     Uses the slot of the given workspace (created by `createWorkspace()` of the same object), or grabs one of the
+     shared slots for the lifetime of the object. It never allocates: if all slots are taken, the slots were sized
+     too small, and it waits until one is released.
+     */
+    class ScopedSlot
+    {
+    public:
+        ScopedSlot (const ConcurrentSlots& ownerSlots, FFTWorkspace* workspace = nullptr) : owner (ownerSlots)
+        {
+            if (workspace != nullptr)
+            {
+                slot = static_cast<Workspace*> (workspace)->slot.get();
+                return;
+            }
+
+            if (tryToGrabSlot())
+                return;
+
+            // more threads than slots, see the numberOfSlots of the constructor
+            jassertfalse;
+
+            while (! tryToGrabSlot())
+                Thread::yield();
+        }
+
+        ~ScopedSlot()
+        {
+            if (index >= 0)
+                owner.inUse[index] = false;
+        }
+
+        Slot* operator->() const noexcept { return slot; }
+        Slot& operator*() const noexcept { return *slot; }
+
+    private:
+        bool tryToGrabSlot() noexcept
+        {
+            for (int i = 0; i < owner.numSlots; ++i)
+            {
+                bool expected = false;
+                if (owner.inUse[i].compare_exchange_strong (expected, true))
+                {
+                    index = i;
+                    slot = owner.slots.getUnchecked (i);
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        const ConcurrentSlots& owner;
+        Slot* slot = nullptr;
+        int index = -1;
+    };
+
+private:
+    struct Workspace : public FFTWorkspace
+    {
+        std::unique_ptr<Slot> slot;
+    };
+
+    const std::function<Slot*()> createSlot;
+    const int numSlots;
+    OwnedArray<Slot> slots;
+    std::unique_ptr<std::atomic<bool>[]> inUse;
+};
+
+//==============================================================================
+/**
+ Interface of a real-only FFT of a fixed size. All backends use the data layout of juce::dsp::FFT, so the
+ frame callbacks don't depend on the backend: the spectrum consists of interleaved real and imaginary parts,
+ and the inverse transform only reads the non-negative frequencies and is scaled by 1 / size.
+
+ The perform methods have to be callable from several threads at once, as a plan is shared by all processors.
+ Backends which need scratch memory for a transform return it from `createWorkspace()`: a thread which passes its own
+ workspace never waits for, or competes with, other threads. SampleType is float or double.
+ */
+template <typename SampleType>
+class FFTBackend
+{
+public:
+    virtual ~FFTBackend() {}
+
+    virtual int getSize() const noexcept = 0;
+
+    /** Name of the backend, e.g. for benchmark reports. */
+    virtual String getName() const = 0;
+
+    /**
+     Creates the scratch memory for the transforms of one thread, which it passes to the perform methods.
+     Returns nullptr if the backend doesn't need any (default).
+     */
+    virtual std::unique_ptr<FFTWorkspace> createWorkspace() const { return nullptr; }
+
+    /**
+     Performs a forward transform of `getSize()` real samples. The result are `getSize()` complex values
+     (or only the size / 2 + 1 non-negative ones), so `inOutData` has to hold 2 * size values.
+     @param workspace a workspace of this backend, which isn't used by another thread at the same time, or nullptr
+     */
+    virtual void performRealOnlyForwardTransform (SampleType* inOutData, bool onlyCalculateNonNegativeFrequencies = false, FFTWorkspace* workspace = nullptr) const noexcept = 0;
+
+    /** Performs an inverse transform of a spectrum in the layout returned by `performRealOnlyForwardTransform()`. */
+    virtual void performRealOnlyInverseTransform (SampleType* inOutData, FFTWorkspace* workspace = nullptr) const noexcept = 0;
+
+    /** Calculates the magnitudes of the spectrum, `inOutData` has to hold 2 * size values. */
+    virtual void performFrequencyOnlyForwardTransform (SampleType* inOutData, FFTWorkspace* workspace = nullptr) const noexcept
+    {
+        const int size = getSize();
+        performRealOnlyForwardTransform (inOutData, false, workspace);
+
+        const auto* spectrum = reinterpret_cast<const std::complex<SampleType>*> (inOutData);
+        for (int k = 0; k < size; ++k)
+            inOutData[k] = std::abs (spectrum[k]);
+    }
+
+};
+
+/** Returns log2 of a power of 2. */
+static inline int getFFTOrder (const int powerOfTwo)
+{
+    int order = 0;
+    while ((1 << order) < powerOfTwo)
+        ++order;
+
+    return order;
+}
+
+//==============================================================================
+/** Power of two sizes in single precision, calculated by juce::dsp::FFT (which uses IPP, vDSP or FFTW if available). */
+class JuceFFTBackend : public FFTBackend<float>
+{
+public:
+    JuceFFTBackend (const int fftSize)
+    : size (fftSize), engines ([fftSize] { return new dsp::FFT (getFFTOrder (fftSize)); })
+    {
+        jassert (isPowerOfTwo (size));
+    }
+
+    int getSize() const noexcept override { return size; }
+    String getName() const override { return "juce::dsp::FFT"; }
+
+    std::unique_ptr<FFTWorkspace> createWorkspace() const override { return engines.createWorkspace(); }
+
+    void performRealOnlyForwardTransform (float* inOutData, bool onlyCalculateNonNegativeFrequencies = false, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        Engines::ScopedSlot engine (engines, workspace);
+        engine->performRealOnlyForwardTransform (inOutData, onlyCalculateNonNegativeFrequencies);
+    }
+
+    void performRealOnlyInverseTransform (float* inOutData, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        Engines::ScopedSlot engine (engines, workspace);
+        engine->performRealOnlyInverseTransform (inOutData);
+    }
+
+    void performFrequencyOnlyForwardTransform (float* inOutData, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        Engines::ScopedSlot engine (engines, workspace);
+        engine->performFrequencyOnlyForwardTransform (inOutData);
+    }
+
+private:
+    using Engines = ConcurrentSlots<dsp::FFT>;
+
+    const int size;
+    Engines engines;
+
+    JUCE_DECLARE_NON_COPYABLE (JuceFFTBackend)
+};
+
+//==============================================================================
+/**
+ In-place complex radix-2 transform of power of 2 sizes on split-complex arrays, unscaled. The butterflies of all
+ stages with at least as many butterflies per group as a dsp::SIMDRegister has lanes are vectorized, so the arrays
+ have to be aligned like those of SplitComplexBuffer. Used for the precisions juce::dsp::FFT doesn't support.
+ */
+template <typename SampleType>
+class RadixTwoComplexFFT
+{
+public:
+    using Register = dsp::SIMDRegister<SampleType>;
+    static constexpr int numLanes = (int) Register::SIMDNumElements;
+
+    RadixTwoComplexFFT (const int fftSize) : size (fftSize), twiddles (2, fftSize)
+    {
+        jassert (isPowerOfTwo (size));
+
+        const int order = getFFTOrder (size);
+        bitReversed.malloc ((size_t) size);
+        for (int i = 0; i < size; ++i)
+        {
+            int reversed = 0;
+            for (int bit = 0; bit < order; ++bit)
+                reversed |= ((i >> bit) & 1) << (order - 1 - bit);
+
+            bitReversed[i] = reversed;
+        }
+
+        // the twiddles exp (-2 pi i j / length) of the stage with halfLength butterflies per group start at index halfLength,
+        // so they are aligned for the vectorized stages; channel 1 holds the conjugated ones of the inverse transform
+        for (int halfLength = 1; halfLength < size; halfLength <<= 1)
+            for (int j = 0; j < halfLength; ++j)
+            {
+                const double phase = -MathConstants<double>::pi * j / halfLength;
+                twiddles.getRealPointer (0)[halfLength + j] = twiddles.getRealPointer (1)[halfLength + j] = (SampleType) std::cos (phase);
+                twiddles.getImagPointer (0)[halfLength + j] = (SampleType) std::sin (phase);
+                twiddles.getImagPointer (1)[halfLength + j] = (SampleType) -std::sin (phase);
+            }
+    }
+
+    int getSize() const noexcept { return size; }
+
+    void perform (SampleType* re, SampleType* im, const bool inverse) const noexcept
+    {
+        for (int i = 0; i < size; ++i)
+        {
+            const int j = bitReversed[i];
+            if (i < j)
+            {
+                std::swap (re[i], re[j]);
+                std::swap (im[i], im[j]);
+            }
+        }
+
+        const SampleType* twiddleRe = twiddles.getRealPointer (inverse ? 1 : 0);
+        const SampleType* twiddleIm = twiddles.getImagPointer (inverse ? 1 : 0);
+
+        for (int halfLength = 1; halfLength < size; halfLength <<= 1)
+        {
+            const SampleType* wRe = twiddleRe + halfLength;
+            const SampleType* wIm = twiddleIm + halfLength;
+
+            for (int start = 0; start < size; start += 2 * halfLength)
+            {
+                SampleType* aRe = re + start;
+                SampleType* aIm = im + start;
+                SampleType* bRe = aRe + halfLength;
+                SampleType* bIm = aIm + halfLength;
+
+                if (halfLength >= numLanes)
+                {
+                    for (int j = 0; j < halfLength; j += numLanes)
+                    {
+                        const auto xRe = Register::fromRawArray (bRe + j);
+                        const auto xIm = Register::fromRawArray (bIm + j);
+                        const auto twRe = Register::fromRawArray (wRe + j);
+                        const auto twIm = Register::fromRawArray (wIm + j);
+                        const auto tRe = xRe * twRe - xIm * twIm;
+                        const auto tIm = xRe * twIm + xIm * twRe;
+
+                        const auto uRe = Register::fromRawArray (aRe + j);
+                        const auto uIm = Register::fromRawArray (aIm + j);
+
+                        (uRe + tRe).copyToRawArray (aRe + j);
+                        (uIm + tIm).copyToRawArray (aIm + j);
+                        (uRe - tRe).copyToRawArray (bRe + j);
+                        (uIm - tIm).copyToRawArray (bIm + j);
+                    }
+                }
+                else
+                {
+                    for (int j = 0; j < halfLength; ++j)
+                    {
+                        const SampleType tRe = bRe[j] * wRe[j] - bIm[j] * wIm[j];
+                        const SampleType tIm = bRe[j] * wIm[j] + bIm[j] * wRe[j];
+
+                        bRe[j] = aRe[j] - tRe;
+                        bIm[j] = aIm[j] - tIm;
+                        aRe[j] += tRe;
+                        aIm[j] += tIm;
+                    }
+                }
+            }
+        }
+    }
+
+private:
+    const int size;
+    HeapBlock<int> bitReversed;
+    SplitComplexBuffer<SampleType> twiddles;
+
+    JUCE_DECLARE_NON_COPYABLE (RadixTwoComplexFFT)
+};
+
+//==============================================================================
+/**
+ Power of two sizes in any precision, e.g. double, which juce::dsp::FFT doesn't support. The real transform of size N
+ is done with a RadixTwoComplexFFT of size N / 2.
+ */
+template <typename SampleType>
+class RadixTwoFFTBackend : public FFTBackend<SampleType>
+{
+public:
+    RadixTwoFFTBackend (const int fftSize)
+    : size (fftSize), halfSize (fftSize / 2), complexFFT (fftSize / 2),
+      slots ([this] { return new SplitComplexBuffer<SampleType> (1, halfSize); })
+    {
+        jassert (isPowerOfTwo (size) && size >= 2);
+
+        // twiddles exp (-2 pi i k / N) for k in [0, N / 2]
+        twiddleRe.malloc ((size_t) halfSize + 1);
+        twiddleIm.malloc ((size_t) halfSize + 1);
+        for (int k = 0; k <= halfSize; ++k)
+        {
+            const double phase = -2.0 * MathConstants<double>::pi * k / size;
+            twiddleRe[k] = (SampleType) std::cos (phase);
+            twiddleIm[k] = (SampleType) std::sin (phase);
+        }
+    }
+
+    int getSize() const noexcept override { return size; }
+    String getName() const override { return "radix-2"; }
+
+    std::unique_ptr<FFTWorkspace> createWorkspace() const override { return slots.createWorkspace(); }
+
+    void performRealOnlyForwardTransform (SampleType* inOutData, bool onlyCalculateNonNegativeFrequencies = false, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        typename Slots::ScopedSlot slot (slots, workspace);
+        SampleType* re = slot->getRealPointer (0);
+        SampleType* im = slot->getImagPointer (0);
+
+        // z[n] = x[2n] + i x[2n + 1]
+        for (int n = 0; n < halfSize; ++n)
+        {
+            re[n] = inOutData[2 * n];
+            im[n] = inOutData[2 * n + 1];
+        }
+
+        complexFFT.perform (re, im, false);
+
+        // X[k] = E[k] + W^k O[k], with the spectra of the even and odd samples E[k] = (Z[k] + Z*[M - k]) / 2 and O[k] = (Z[k] - Z*[M - k]) / 2i
+        for (int k = 0; k <= halfSize; ++k)
+        {
+            const int index = k % halfSize;
+            const int mirroredIndex = (halfSize - k) % halfSize;
+
+            const SampleType evenRe = (SampleType) 0.5 * (re[index] + re[mirroredIndex]);
+            const SampleType evenIm = (SampleType) 0.5 * (im[index] - im[mirroredIndex]);
+            const SampleType oddRe = (SampleType) 0.5 * (im[index] + im[mirroredIndex]);
+            const SampleType oddIm = (SampleType) 0.5 * (re[mirroredIndex] - re[index]);
+
+            inOutData[2 * k] = evenRe + twiddleRe[k] * oddRe - twiddleIm[k] * oddIm;
+            inOutData[2 * k + 1] = evenIm + twiddleRe[k] * oddIm + twiddleIm[k] * oddRe;
+        }
+
+        if (! onlyCalculateNonNegativeFrequencies)
+            for (int k = halfSize + 1; k < size; ++k)
+            {
+                inOutData[2 * k] = inOutData[2 * (size - k)];
+                inOutData[2 * k + 1] = -inOutData[2 * (size - k) + 1];
+            }
+    }
+
+    void performRealOnlyInverseTransform (SampleType* inOutData, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        typename Slots::ScopedSlot slot (slots, workspace);
+        SampleType* re = slot->getRealPointer (0);
+        SampleType* im = slot->getImagPointer (0);
+
+        // Z[k] = E[k] + i O[k], with E[k] = (X[k] + X*[M - k]) / 2 and O[k] = (X[k] - X*[M - k]) W^-k / 2
+        for (int k = 0; k < halfSize; ++k)
+        {
+            const SampleType xRe = inOutData[2 * k];
+            const SampleType xIm = inOutData[2 * k + 1];
+            const SampleType mRe = inOutData[2 * (halfSize - k)];
+            const SampleType mIm = inOutData[2 * (halfSize - k) + 1];
+
+            const SampleType evenRe = (SampleType) 0.5 * (xRe + mRe);
+            const SampleType evenIm = (SampleType) 0.5 * (xIm - mIm);
+            const SampleType differenceRe = (SampleType) 0.5 * (xRe - mRe);
+            const SampleType differenceIm = (SampleType) 0.5 * (xIm + mIm);
+            const SampleType oddRe = differenceRe * twiddleRe[k] + differenceIm * twiddleIm[k];
+            const SampleType oddIm = differenceIm * twiddleRe[k] - differenceRe * twiddleIm[k];
+
+            re[k] = evenRe - oddIm;
+            im[k] = evenIm + oddRe;
+        }
+
+        complexFFT.perform (re, im, true);
+
+        // x[2n] = Re z[n], x[2n + 1] = Im z[n]
+        const SampleType scale = (SampleType) 1 / halfSize;
+        for (int n = 0; n < halfSize; ++n)
+        {
+            inOutData[2 * n] = scale * re[n];
+            inOutData[2 * n + 1] = scale * im[n];
+        }
+    }
+
+private:
+    using Slots = ConcurrentSlots<SplitComplexBuffer<SampleType>>;
+
+    const int size;
+    const int halfSize;
+    RadixTwoComplexFFT<SampleType> complexFFT;
+    HeapBlock<SampleType> twiddleRe, twiddleIm;
+    Slots slots;
+
+    JUCE_DECLARE_NON_COPYABLE (RadixTwoFFTBackend)
+};
+
+//==============================================================================
+/**
+ Out-of-place complex transform with the interface and scaling of juce::dsp::FFT::perform(), which is used for float.
+ Other precisions use a RadixTwoComplexFFT.
+ */
+template <typename SampleType>
+class ComplexFFTEngine
+{
+public:
+    ComplexFFTEngine (const int fftSize) : fft (fftSize), buffer (1, fftSize) {}
+
+    void perform (const std::complex<SampleType>* input, std::complex<SampleType>* output, const bool inverse) noexcept
+    {
+        const int size = fft.getSize();
+        SampleType* re = buffer.getRealPointer (0);
+        SampleType* im = buffer.getImagPointer (0);
+
+        for (int i = 0; i < size; ++i)
+        {
+            re[i] = input[i].real();
+            im[i] = input[i].imag();
+        }
+
+        fft.perform (re, im, inverse);
+
+        const SampleType scale = inverse ? (SampleType) 1 / size : (SampleType) 1;
+        for (int i = 0; i < size; ++i)
+            output[i] = std::complex<SampleType> (scale * re[i], scale * im[i]);
+    }
+
+private:
+    RadixTwoComplexFFT<SampleType> fft;
+    SplitComplexBuffer<SampleType> buffer;
+};
+
+template <>
+class ComplexFFTEngine<float>
+{
+public:
+    ComplexFFTEngine (const int fftSize) : fft (getFFTOrder (fftSize)) {}
+
+    void perform (const std::complex<float>* input, std::complex<float>* output, const bool inverse) noexcept
+    {
+        fft.perform (input, output, inverse);
+    }
+
+private:
+    dsp::FFT fft;
+};
+
+//==============================================================================
+/**
+ Arbitrary sizes, calculated with Bluestein's algorithm, which uses three power of two transforms
+ (a ComplexFFTEngine) of at least twice the size.
+ */
+template <typename SampleType>
+class BluesteinFFTBackend : public FFTBackend<SampleType>
+{
+public:
+    BluesteinFFTBackend (const int fftSize)
+    : size (fftSize), convolutionSize (nextPowerOfTwo (2 * fftSize - 1)),
+      slots ([this] { return new Slot (convolutionSize); })
+    {
+        jassert (size > 0);
+
+        // chirp: exp (-i pi n^2 / N), calculated with n^2 mod 2N to keep precision for large n
+        chirp.malloc ((size_t) size);
+        for (int n = 0; n < size; ++n)
+        {
+            const auto nSquared = ((int64) n * n) % (2 * size);
+            const double phase = -MathConstants<double>::pi * (double) nSquared / size;
+            chirp[n] = Complex ((SampleType) std::cos (phase), (SampleType) std::sin (phase));
+        }
+
+        // spectrum of the (circularly wrapped) conjugated chirp, the kernel of the convolution
+        chirpSpectrum.calloc ((size_t) convolutionSize);
+        chirpSpectrum[0] = std::conj (chirp[0]);
+        for (int n = 1; n < size; ++n)
+            chirpSpectrum[n] = chirpSpectrum[convolutionSize - n] = std::conj (chirp[n]);
+
+        HeapBlock<Complex> kernel ((size_t) convolutionSize);
+        std::copy (chirpSpectrum.get(), chirpSpectrum.get() + convolutionSize, kernel.get());
+
+        typename Slots::ScopedSlot slot (slots);
+        slot->fft.perform (kernel.get(), chirpSpectrum.get(), false);
+    }
+
+    int getSize() const noexcept override { return size; }
+    String getName() const override { return "Bluestein"; }
+
+    std::unique_ptr<FFTWorkspace> createWorkspace() const override { return slots.createWorkspace(); }
+
+    void performRealOnlyForwardTransform (SampleType* inOutData, bool onlyCalculateNonNegativeFrequencies = false, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        const int numBins = onlyCalculateNonNegativeFrequencies ? size / 2 + 1 : size;
+        typename Slots::ScopedSlot slot (slots, workspace);
+        auto* data = slot->data.get();
+
+        for (int n = 0; n < size; ++n)
+            data[n] = chirp[n] * inOutData[n];
+
+        std::fill (data + size, data + convolutionSize, Complex());
+        convolveWithChirp (*slot);
+
+        auto* out = reinterpret_cast<Complex*> (inOutData);
+        for (int k = 0; k < numBins; ++k)
+            out[k] = chirp[k] * data[k];
+    }
+
+    void performRealOnlyInverseTransform (SampleType* inOutData, FFTWorkspace* workspace = nullptr) const noexcept override
+    {
+        // x[n] = 1/N Re (DFT (conj (X))[n]), with the negative frequencies being the conjugated positive ones
+        const auto* in = reinterpret_cast<const Complex*> (inOutData);
+        typename Slots::ScopedSlot slot (slots, workspace);
+        auto* data = slot->data.get();
+
+        for (int k = 0; k <= size / 2; ++k)
+            data[k] = chirp[k] * std::conj (in[k]);
+
+        for (int k = size / 2 + 1; k < size; ++k)
+            data[k] = chirp[k] * in[size - k];
+
+        std::fill (data + size, data + convolutionSize, Complex());
+        convolveWithChirp (*slot);
+
+        const SampleType scale = (SampleType) 1 / size;
+        for (int n = 0; n < size; ++n)
+            inOutData[n] = scale * (chirp[n] * data[n]).real();
+    }
+
+private:
+    using Complex = std::complex<SampleType>;
+
+    /** Everything a single transform needs: the power of two FFT and two buffers, as it works out-of-place. */
+    struct Slot
+    {
+        Slot (const int convolutionSize) : fft (convolutionSize), data ((size_t) convolutionSize), temp ((size_t) convolutionSize) {}
+
+        ComplexFFTEngine<SampleType> fft;
+        HeapBlock<Complex> data, temp;
+    };
+
+    using Slots = ConcurrentSlots<Slot>;
+
+    /** Circular convolution of the slot's data with the chirp kernel. */
+    void convolveWithChirp (Slot& slot) const noexcept
+    {
+        slot.fft.perform (slot.data.get(), slot.temp.get(), false);
+
+        for (int i = 0; i < convolutionSize; ++i)
+            slot.temp[i] *= chirpSpectrum[i];
+
+        slot.fft.perform (slot.temp.get(), slot.data.get(), true);
+    }
+
+    const int size;
+    const int convolutionSize;
+    HeapBlock<Complex> chirp, chirpSpectrum;
+    Slots slots;
+
+    JUCE_DECLARE_NON_COPYABLE (BluesteinFFTBackend)
+};
+
+//==============================================================================
+#if OVERLAPPINGFFTPROCESSOR_USE_FFTW
+/** The FFTW functions of a precision: fftwf_ (libfftw3f) for float, and fftw_ (libfftw3) for double. */
+template <typename SampleType>
+struct FFTWFunctions;
+
+template <>
+struct FFTWFunctions<float>
+{
+    using Plan = fftwf_plan;
+    using Complex = fftwf_complex;
+
+    static Plan planForward (int n, float* in, Complex* out, unsigned flags) { return fftwf_plan_dft_r2c_1d (n, in, out, flags); }
+    static Plan planInverse (int n, Complex* in, float* out, unsigned flags) { return fftwf_plan_dft_c2r_1d (n, in, out, flags); }
+    static void executeForward (const Plan plan, float* in, Complex* out) { fftwf_execute_dft_r2c (plan, in, out); }
+    static void executeInverse (const Plan plan, Complex* in, float* out) { fftwf_execute_dft_c2r (plan, in, out); }
+    static void destroy (Plan plan) { fftwf_destroy_plan (plan); }
+};
+
+template <>
+struct FFTWFunctions<double>
+{
+    using Plan = fftw_plan;
+    using Complex = fftw_complex;
+
+    static Plan planForward (int n, double* in, Complex* out, unsigned flags) { return fftw_plan_dft_r2c_1d (n, in, out, flags); }
+    static Plan planInverse (int n, Complex* in, double* out, unsigned flags) { return fftw_plan_dft_c2r_1d (n, in, out, flags); }
+    static void executeForward (const Plan plan, double* in, Complex* out) { fftw_execute_dft_r2c (plan, in, out); }
+    static void executeInverse (const Plan plan, Complex* in, double* out) { fftw_execute_dft_c2r (plan, in, out); }
+    static void destroy (Plan plan) { fftw_destroy_plan (plan); }
+};
+
+/** Arbitrary sizes, calculated by FFTW with in-place plans created with FFTW_MEASURE. */
+template <typename SampleType>
+class FFTWBackend : public FFTBackend<SampleType>
+{
+public:
+    /** Creates the plans, make sure no other thread uses the FFTW planner at the same time (`FFTPlanCache` takes care of that). */
+    FFTWBackend (const int fftSize) : size (fftSize)
+    {
+        // FFTW_MEASURE overwrites the arrays, so we plan with some scratch memory and use the new-array execute functions later on
+        HeapBlock<SampleType> scratch ((size_t) (2 * (size / 2 + 1)));
+        auto* complexScratch = reinterpret_cast<FFTWComplex*> (scratch.get());
+
+        forwardPlan = FFTW::planForward (size, scratch.get(), complexScratch, FFTW_MEASURE | FFTW_UNALIGNED);
+        inversePlan = FFTW::planInverse (size, complexScratch, scratch.get(), FFTW_MEASURE | FFTW_UNALIGNED);
+    }
+
+    ~FFTWBackend()
+    {
+        FFTW::destroy (forwardPlan);
+        FFTW::destroy (inversePlan);
+    }
+
+    int getSize() const noexcept override { return size; }
+    String getName() const override { return "FFTW"; }
+
+    void performRealOnlyForwardTransform (SampleType* inOutData, bool onlyCalculateNonNegativeFrequencies = false, FFTWorkspace* = nullptr) const noexcept override
+    {
+        FFTW::executeForward (forwardPlan, inOutData, reinterpret_cast<FFTWComplex*> (inOutData));
+
+        if (! onlyCalculateNonNegativeFrequencies)
+        {
+            auto* spectrum = reinterpret_cast<std::complex<SampleType>*> (inOutData);
+            for (int k = size / 2 + 1; k < size; ++k)
+                spectrum[k] = std::conj (spectrum[size - k]);
+        }
+    }
+
+    void performRealOnlyInverseTransform (SampleType* inOutData, FFTWorkspace* = nullptr) const noexcept override
+    {
+        FFTW::executeInverse (inversePlan, reinterpret_cast<FFTWComplex*> (inOutData), inOutData);
+        FloatVectorOperations::multiply (inOutData, (SampleType) 1 / size, size);
+    }
+
+private:
+    using FFTW = FFTWFunctions<SampleType>;
+    using FFTWComplex = typename FFTW::Complex;
+
+    const int size;
+    typename FFTW::Plan forwardPlan, inversePlan;
+
+    JUCE_DECLARE_NON_COPYABLE (FFTWBackend)
+};
+#endif
+
+//==============================================================================
+/**
+ Process-wide cache of FFT plans, keyed on the size, so processor instances with the same fftSize share
+ the same plan instead of planning (and allocating) it again. Hold it with a SharedResourcePointer.
+ Plans are deleted as soon as no processor uses them anymore.
+
+ Which backend is used is decided by a factory function, by default FFTW (if OVERLAPPINGFFTPROCESSOR_USE_FFTW
+ is set), otherwise juce::dsp::FFT (float) or RadixTwoFFTBackend (double) for powers of 2, and Bluestein's algorithm
+ for all other sizes. Other libraries (e.g. PFFFT) can be plugged in with `setFactory()` and an implementation of `FFTBackend`.
+ There's one cache for each SampleType.
+ */
+template <typename SampleType>
+class FFTPlanCache
+{
+public:
+    using Backend = FFTBackend<SampleType>;
+    using Factory = std::function<std::unique_ptr<Backend> (int fftSize)>;
+
+    FFTPlanCache() : factory (createDefaultBackend) {}
+
+    /** Returns the plan for the given size, and creates it if there's none yet. Don't call this from the audio thread. */
+    std::shared_ptr<const Backend> getPlan (const int fftSize)
+    {
+        const ScopedLock sl (lock);
+
+        auto& cachedPlan = plans[fftSize];
+        if (auto plan = cachedPlan.lock())
+            return plan;
+
+        std::shared_ptr<const Backend> plan (factory (fftSize));
+        cachedPlan = plan;
+        return plan;
+    }
+
+    /** Sets the factory for plans which are created from now on. Existing plans stay in use until their processors change their resolution. */
+    void setFactory (Factory newFactory)
+    {
+        const ScopedLock sl (lock);
+        factory = std::move (newFactory);
+        plans.clear();
+    }
+
+    /**
+     Returns true if the plan is the default backend for powers of 2 (juce::dsp::FFT or RadixTwoFFTBackend), which the
+     processors replace with batched transforms for many channels, see BatchedRealFFT. Plans of FFTW or of a factory set
+     with `setFactory()` are never replaced.
+     */
+    static bool isDefaultPowerOfTwoBackend (const Backend& plan)
+    {
+        return isDefaultPowerOfTwoBackend (plan, SampleType());
+    }
+
+    static std::unique_ptr<Backend> createDefaultBackend (const int fftSize)
+    {
+       #if OVERLAPPINGFFTPROCESSOR_USE_FFTW
+        return std::unique_ptr<Backend> (new FFTWBackend<SampleType> (fftSize));
+       #else
+        if (isPowerOfTwo (fftSize))
+            return createPowerOfTwoBackend (fftSize, SampleType());
+
+        return std::unique_ptr<Backend> (new BluesteinFFTBackend<SampleType> (fftSize));
+       #endif
+    }
+
+private:
+    // juce::dsp::FFT only supports float
+    static std::unique_ptr<FFTBackend<float>> createPowerOfTwoBackend (const int fftSize, float)
+    {
+        return std::unique_ptr<FFTBackend<float>> (new JuceFFTBackend (fftSize));
+    }
+
+    static std::unique_ptr<FFTBackend<double>> createPowerOfTwoBackend (const int fftSize, double)
+    {
+        return std::unique_ptr<FFTBackend<double>> (new RadixTwoFFTBackend<double> (fftSize));
+    }
+
+    static bool isDefaultPowerOfTwoBackend (const FFTBackend<float>& plan, float)
+    {
+        return dynamic_cast<const JuceFFTBackend*> (&plan) != nullptr;
+    }
+
+    static bool isDefaultPowerOfTwoBackend (const FFTBackend<double>& plan, double)
+    {
+        return dynamic_cast<const RadixTwoFFTBackend<double>*> (&plan) != nullptr;
+    }
+
+    CriticalSection lock;
+    Factory factory;
+    std::map<int, std::weak_ptr<const Backend>> plans;
+
+    JUCE_DECLARE_NON_COPYABLE (FFTPlanCache)
+};
@@ -0,0 +1,310 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ Automation of the parameters of an OverlappingFFTProcessor, which the frame callbacks read as one snapshot per frame,
+ interpolated to the frame's centre. Set it up with `setNumFrameParameters()` of the processor.
+
+ Each parameter is a piecewise linear curve over the input samples, through the breakpoints added by the changes:
+  - `setValue()` can be called from any thread (e.g. by a parameter listener), without locking. The audio thread picks
+    the latest value up at the start of its next block, and ramps to it over the ramp length, up to the block's first sample.
+  - `addEvent()` adds a change at a sample of the next block (e.g. from host automation or MIDI controllers), only call it
+    from the audio thread before `process()`. It ramps from the previous change, but at most over the ramp length.
+
+ A frame only uses the breakpoints before its last sample, and the ramps have a fixed length, so the snapshots of the
+ events don't depend on the host's block size. Changes by `setValue()` do, as they take effect at the next block start.
+ All memory is allocated in `prepare()`, the audio thread never allocates or locks.
+ */
+class FrameParameters
+{
+public:
+    FrameParameters() {}
+
+    /**
+     Sets the number of parameters, their values are 0 until they're set with `setValue()`. Don't call it while the
+     processor is running, or concurrently with `setValue()`.
+     @param numberOfParameters number of parameters
+     @param maximumNumEventsPerBlock maximum number of `addEvent()` calls per block. The curves keep all changes within
+            the history, as long as the blocks aren't shorter than the maximum block size passed to `prepare()`. Otherwise,
+            the breakpoints which matter the least are merged into their neighbours.
+     @param maximumRampLength number of samples `setValue()` changes ramp over, and the maximum for `addEvent()`,
+            0 changes the value at the block start or the event's sample
+     */
+    void setNumParameters (const int numberOfParameters, const int maximumNumEventsPerBlock, const int maximumRampLength)
+    {
+        jassert (numberOfParameters >= 0 && maximumNumEventsPerBlock >= 0 && maximumRampLength >= 0);
+
+        targets.reset (numberOfParameters > 0 ? new std::atomic<float>[(size_t) numberOfParameters] : nullptr);
+        for (int i = 0; i < numberOfParameters; ++i)
+            targets[(size_t) i] = 0.0f;
+
+        numParameters = numberOfParameters;
+        maxNumEvents = maximumNumEventsPerBlock;
+        rampLength = maximumRampLength;
+    }
+
+    /**
+     Allocates the curves, which start with the current values. Called by `prepare()` of the processor.
+     @param historyLength number of past samples for which the curves have to be kept, i.e. the maximum fftSize
+     @param maximumBlockSize the maximum number of samples of a block
+     */
+    void prepare (const int historyLength, const int maximumBlockSize)
+    {
+        keptHistory = historyLength;
+
+        events.malloc ((size_t) jmax (1, maxNumEvents));
+        numEvents = 0;
+
+        // each change adds at most two breakpoints (the start and the end of its ramp): a block adds at most two for
+        // `setValue()` and two for each event. When a block's changes are added, the curves still hold the blocks within
+        // the history before the previous block start (and one breakpoint before it), the previous block and the new one.
+        const int blockSize = jmax (1, maximumBlockSize);
+        const int numBlocks = (historyLength + blockSize - 1) / blockSize + 2;
+        capacity = 2 * (maxNumEvents + 1) * numBlocks + 1;
+        breakpoints.malloc ((size_t) jmax (1, numParameters * capacity));
+        firstBreakpoints.calloc ((size_t) jmax (1, numParameters));
+        numBreakpoints.calloc ((size_t) jmax (1, numParameters));
+        pickedUpValues.malloc ((size_t) jmax (1, numParameters));
+
+        for (int i = 0; i < numParameters; ++i)
+        {
+            pickedUpValues[i] = targets[(size_t) i].load();
+            addBreakpoint (i, std::numeric_limits<int64>::min() / 2, pickedUpValues[i]);
+        }
+    }
+
+    /** Returns the number of bytes allocated for the curves and events. */
+    size_t getSizeInBytes() const noexcept
+    {
+        return (size_t) numParameters * (sizeof (std::atomic<float>) + sizeof (float) + 2 * sizeof (int) + (size_t) capacity * sizeof (Breakpoint))
+                 + (size_t) maxNumEvents * sizeof (Event);
+    }
+
+    int getNumParameters() const noexcept { return numParameters; }
+
+    /** Sets the value of a parameter, from any thread. Before `prepare()`, it sets the initial value. */
+    void setValue (const int index, const float value) noexcept
+    {
+        jassert (isPositiveAndBelow (index, numParameters));
+        targets[(size_t) index].store (value, std::memory_order_relaxed);
+    }
+
+    /** Returns the latest value set with `setValue()`. */
+    float getValue (const int index) const noexcept
+    {
+        jassert (isPositiveAndBelow (index, numParameters));
+        return targets[(size_t) index].load (std::memory_order_relaxed);
+    }
+
+    /**
+     Adds a change at a sample of the next block, only from the audio thread. Add the events in the order of their samples,
+     the offset has to be less than the number of samples of the block, later offsets are moved to its last sample.
+     */
+    void addEvent (const int index, const float value, const int sampleOffset) noexcept
+    {
+        jassert (isPositiveAndBelow (index, numParameters) && sampleOffset >= 0);
+        jassert (numEvents == 0 || events[numEvents - 1].sampleOffset <= sampleOffset);
+
+        // more events than passed to prepare(), the rest of this block's events is dropped
+        jassert (numEvents < maxNumEvents);
+        if (numEvents < maxNumEvents)
+            events[numEvents++] = { index, value, sampleOffset };
+    }
+
+    /** Picks up the new values and the events of a block of `numSamples` starting at the given input sample. Called by the processor. */
+    void beginBlock (const int64 position, const int numSamples) noexcept
+    {
+        for (int i = 0; i < numParameters; ++i)
+        {
+            const float target = targets[(size_t) i].load (std::memory_order_relaxed);
+            if (target != pickedUpValues[i])
+            {
+                pickedUpValues[i] = target;
+                addChange (i, position, target, rampLength);
+            }
+        }
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            // an event beyond the block would end up after the changes of the next block
+            jassert (events[i].sampleOffset < jmax (1, numSamples));
+            const int sampleOffset = jmin (events[i].sampleOffset, jmax (0, numSamples - 1));
+            addChange (events[i].index, position + sampleOffset, events[i].value, rampLength);
+        }
+
+        numEvents = 0;
+
+        // only the last breakpoint before the oldest frame which will still be started is needed
+        for (int i = 0; i < numParameters; ++i)
+            while (numBreakpoints[i] > 1 && getBreakpoint (i, 1).position <= position - keptHistory)
+                removeOldestBreakpoint (i);
+    }
+
+    /**
+     Fills the values of all parameters at an input position (e.g. the centre of a frame), only using the breakpoints
+     before `knownEnd`. Returns nullptr if there are no parameters. Called by the processor.
+     */
+    const float* getSnapshot (float* destination, const double position, const int64 knownEnd) const noexcept
+    {
+        if (numParameters == 0)
+            return nullptr;
+
+        for (int i = 0; i < numParameters; ++i)
+            destination[i] = getValueAt (i, position, knownEnd);
+
+        return destination;
+    }
+
+private:
+    struct Breakpoint
+    {
+        int64 position;
+        float value;
+    };
+
+    struct Event
+    {
+        int index;
+        float value;
+        int sampleOffset;
+    };
+
+    /**
+     A change ramps from the last breakpoint, if that's within the ramp length. Otherwise, the value is held until the ramp starts.
+     A change before the last breakpoint (events out of order) is moved to it, so the breakpoints stay sorted.
+     */
+    void addChange (const int index, const int64 changePosition, const float value, const int length) noexcept
+    {
+        const auto& newest = getBreakpoint (index, numBreakpoints[index] - 1);
+        const int64 position = jmax (changePosition, newest.position);
+        const int64 rampStart = position - length;
+
+        if (newest.position < rampStart)
+            addBreakpoint (index, rampStart, newest.value);
+
+        addBreakpoint (index, position, value);
+    }
+
+    void addBreakpoint (const int index, const int64 position, const float value) noexcept
+    {
+        // more changes within the history than expected (blocks shorter than the maximum block size)
+        if (numBreakpoints[index] == capacity)
+            mergeLeastSignificantBreakpoint (index);
+
+        getBreakpoint (index, numBreakpoints[index]) = { position, value };
+        ++numBreakpoints[index];
+    }
+
+    /**
+     Removes the breakpoint (but the oldest and the newest) which changes the curve the least, i.e. whose triangle with its
+     neighbours has the smallest area. Collinear and superseded breakpoints go first, so the curve stays exact as long as
+     possible, and the history is never cut short.
+     */
+    void mergeLeastSignificantBreakpoint (const int index) noexcept
+    {
+        jassert (numBreakpoints[index] >= 3);
+
+        int leastSignificant = 1;
+        auto smallestArea = std::numeric_limits<double>::max();
+
+        for (int i = 1; i < numBreakpoints[index] - 1; ++i)
+        {
+            const auto& previous = getBreakpoint (index, i - 1);
+            const auto& breakpoint = getBreakpoint (index, i);
+            const auto& next = getBreakpoint (index, i + 1);
+
+            const auto span = (double) (next.position - previous.position);
+            const double progress = span > 0 ? (double) (breakpoint.position - previous.position) / span : 1.0;
+            const double area = span * std::abs (breakpoint.value - (previous.value + progress * (next.value - previous.value)));
+
+            if (area < smallestArea)
+            {
+                smallestArea = area;
+                leastSignificant = i;
+            }
+        }
+
+        for (int i = leastSignificant; i < numBreakpoints[index] - 1; ++i)
+            getBreakpoint (index, i) = getBreakpoint (index, i + 1);
+
+        --numBreakpoints[index];
+    }
+
+    void removeOldestBreakpoint (const int index) noexcept
+    {
+        firstBreakpoints[index] = (firstBreakpoints[index] + 1) % capacity;
+        --numBreakpoints[index];
+    }
+
+    Breakpoint& getBreakpoint (const int index, const int i) noexcept
+    {
+        return breakpoints[index * capacity + (firstBreakpoints[index] + i) % capacity];
+    }
+
+    const Breakpoint& getBreakpoint (const int index, const int i) const noexcept
+    {
+        return breakpoints[index * capacity + (firstBreakpoints[index] + i) % capacity];
+    }
+
+    float getValueAt (const int index, const double position, const int64 knownEnd) const noexcept
+    {
+        const Breakpoint* next = nullptr;
+
+        for (int i = numBreakpoints[index]; --i >= 0;)
+        {
+            const auto& breakpoint = getBreakpoint (index, i);
+            if (breakpoint.position >= knownEnd)
+                continue;
+
+            if (breakpoint.position <= position)
+            {
+                if (next == nullptr || next->position == breakpoint.position)
+                    return breakpoint.value;
+
+                const auto progress = (float) ((position - breakpoint.position) / (double) (next->position - breakpoint.position));
+                return breakpoint.value + progress * (next->value - breakpoint.value);
+            }
+
+            next = &breakpoint;
+        }
+
+        return next != nullptr ? next->value : 0.0f;
+    }
+
+    int numParameters = 0;
+    std::unique_ptr<std::atomic<float>[]> targets;
+
+    // only used by the audio thread
+    HeapBlock<Event> events;
+    int maxNumEvents = 0;
+    int numEvents = 0;
+    HeapBlock<float> pickedUpValues;
+    HeapBlock<Breakpoint> breakpoints; // a ring of capacity breakpoints for each parameter
+    HeapBlock<int> firstBreakpoints;
+    HeapBlock<int> numBreakpoints;
+    int capacity = 0;
+    int rampLength = 0;
+    int keptHistory = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (FrameParameters)
+};
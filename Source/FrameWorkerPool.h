@@ -0,0 +1,192 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#elif JUCE_ARM && JUCE_MSVC
+ #include <intrin.h>
+#endif
+
+/**
+ A fixed set of pre-spawned worker threads which help the audio thread to work through
+ the tasks of a frame (e.g. one task per channel).
+
+ `perform()` is real-time safe: it doesn't allocate, doesn't lock and never waits for a
+ worker to wake up. The calling thread works on the tasks itself, so if the workers are
+ late it simply does (most of) the work inline, and it only spins for tasks a worker has
+ already started.
+
+ While tasks are coming in regularly, the workers spin (yielding their time slice) in
+ order to pick up new work quickly. After the spin time without any tasks (2 ms by default),
+ they back off and sleep. Spinning costs up to one core per worker as long as the tasks come in
+ more often than the spin time, a shorter spin time saves that CPU, but the workers might be asleep
+ when the next tasks come in, so the calling thread does more of the work itself.
+ */
+class FrameWorkerPool
+{
+public:
+    /** Interface for the work which is distributed over the threads. */
+    struct Job
+    {
+        virtual ~Job() {}
+
+        /** Gets called exactly once for each task index of a `perform()` call. Might be called from any of the threads. */
+        virtual void runTask (const int taskIndex) = 0;
+    };
+
+    static constexpr double defaultSpinTimeInMilliseconds = 2.0;
+
+    /** Constructor
+     @param numberOfWorkerThreads number of threads helping the thread calling `perform()`
+     @param workerSpinTimeInMilliseconds how long the workers spin for new tasks after their last ones, before they sleep
+     */
+    FrameWorkerPool (const int numberOfWorkerThreads, const double workerSpinTimeInMilliseconds = defaultSpinTimeInMilliseconds)
+        : spinTimeInMilliseconds (workerSpinTimeInMilliseconds)
+    {
+        jassert (spinTimeInMilliseconds >= 0.0);
+
+        for (int i = 0; i < numberOfWorkerThreads; ++i)
+            workers.add (new Worker (*this))->startThread (8);
+    }
+
+    ~FrameWorkerPool()
+    {
+        for (auto* worker : workers)
+            worker->signalThreadShouldExit();
+
+        for (auto* worker : workers)
+            worker->stopThread (1000);
+    }
+
+    int getNumWorkerThreads() const { return workers.size(); }
+
+    /**
+     Runs `job.runTask (i)` for all i in [0, numTasks) and returns as soon as all tasks are done.
+     The tasks are handed out in groups of `tasksPerGroup`. Must not be called from several threads at once.
+     */
+    void perform (Job& job, const int numTasks, const int tasksPerGroup = 1)
+    {
+        jassert (tasksPerGroup > 0);
+        jassert (numTasks < 0x8000);
+
+        currentJob = &job;
+        groupSize = jmin (tasksPerGroup, numTasks);
+        numFinishedTasks = 0;
+
+        // publishes the new job: new generation, number of tasks, and first task index 0
+        const auto generation = (state.load() >> 32) + 1;
+        state = (generation << 32) | ((uint64) numTasks << 16);
+
+        while (runNextGroup (generation))
+        {}
+
+        // barrier: wait for tasks which are still processed by workers, they have already started, so it's short
+        while (numFinishedTasks.load() < numTasks)
+            pause();
+    }
+
+private:
+    /** Tells the CPU that this is a spin-wait loop, which saves power and lets the other hyper-thread run. */
+    static void pause() noexcept
+    {
+       #if JUCE_INTEL
+        _mm_pause();
+       #elif JUCE_ARM && JUCE_MSVC
+        __yield();
+       #elif JUCE_ARM
+        __asm__ __volatile__ ("yield");
+       #endif
+    }
+
+    /** Claims the next group of tasks of the given generation and runs it. Returns false if there's nothing left to do. */
+    bool runNextGroup (const uint64 generation)
+    {
+        auto currentState = state.load();
+
+        while (true)
+        {
+            if ((currentState >> 32) != generation)
+                return false;
+
+            const int numTasks = (int) ((currentState >> 16) & 0xffff);
+            const int start = (int) (currentState & 0xffff);
+            if (start >= numTasks)
+                return false;
+
+            const int size = groupSize.load();
+            if (state.compare_exchange_weak (currentState, currentState + (uint64) size))
+            {
+                auto* job = currentJob.load();
+                const int end = jmin (start + size, numTasks);
+                for (int i = start; i < end; ++i)
+                    job->runTask (i);
+
+                numFinishedTasks += end - start;
+                return true;
+            }
+        }
+    }
+
+    class Worker : public Thread
+    {
+    public:
+        Worker (FrameWorkerPool& ownerPool) : Thread ("FrameWorkerPool Worker"), pool (ownerPool) {}
+
+        void run() override
+        {
+            uint64 lastGeneration = pool.state.load() >> 32;
+            auto lastActivity = Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                const auto generation = pool.state.load() >> 32;
+                if (generation != lastGeneration)
+                {
+                    lastGeneration = generation;
+                    while (pool.runNextGroup (generation))
+                    {}
+
+                    lastActivity = Time::getMillisecondCounterHiRes();
+                }
+                else if (Time::getMillisecondCounterHiRes() - lastActivity < pool.spinTimeInMilliseconds)
+                    Thread::yield();
+                else
+                    wait (1);
+            }
+        }
+
+    private:
+        FrameWorkerPool& pool;
+    };
+
+    const double spinTimeInMilliseconds;
+    OwnedArray<Worker> workers;
+
+    // bits 32-63: generation of the current job, bits 16-31: number of tasks, bits 0-15: index of the next task to be claimed
+    std::atomic<uint64> state { 0 };
+    std::atomic<Job*> currentJob { nullptr };
+    std::atomic<int> groupSize { 1 };
+    std::atomic<int> numFinishedTasks { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (FrameWorkerPool)
+};
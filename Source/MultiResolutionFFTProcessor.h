@@ -0,0 +1,418 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "OverlappingFFTProcessor.h"
+
+/**
+ Processes the input with several resolutions at once, e.g. long frames for the low frequencies and short frames
+ for the transients of the high frequencies. Each stage has its own (fftSize, hopSize), but all stages share one
+ input history and one overlap-add output buffer, so the buffering is done only once. Their latencies are aligned to
+ the largest fftSize.
+
+ Each stage covers a frequency band, from low to high, separated by the crossover frequencies. After the
+ `processStageSpectrum()` callback, the spectrum of a stage's frame is multiplied with the stage's band gains, which
+ fade in and out with raised cosines over `getCrossoverWidth()` octaves around the crossovers. The band gains of all
+ stages sum up to 1, so unaltered frames are reconstructed close to perfectly, as long as the crossover regions span
+ several bins of the stages next to them: the band gains act as short filters, which slightly wrap around the frames.
+ E.g. stages of 4096, 1024 and 256 samples with crossovers at 300 Hz and 2.5 kHz (48 kHz) reconstruct white noise with
+ errors below -45 dB with the default width of one octave. So give the lowest band the largest fftSize.
+
+ Each stage starts its frames at its own hop boundaries. Frames of several stages which are due at the same input
+ sample are independent of each other, and are processed in parallel if there are worker threads, see `setNumWorkerThreads()`.
+
+ @code
+ class MyProcessor : public MultiResolutionFFTProcessor
+ {
+ public:
+     MyProcessor() : MultiResolutionFFTProcessor ({ { 4096, 1024 }, { 1024, 256 }, { 256, 64 } }, { 300.0, 2500.0 }) {}
+
+ private:
+     void processStageSpectrum (const int stage, AudioBuffer<float>& spectra, const int maxNumChannels) override
+     {
+         // spectra of the stage's frame, as returned by fft.performRealOnlyForwardTransform (data, true)
+     }
+ };
+ @endcode
+ */
+template <typename SampleType>
+class BasicMultiResolutionFFTProcessor : public OverlappingFFTProcessorBase
+{
+public:
+    /** Constructor
+     @param stageResolutions fftSize and hopSize of each stage, from the lowest to the highest band
+     @param crossoverFrequencies the frequencies in Hz between the bands of the stages (one less than stages), ascending
+     */
+    BasicMultiResolutionFFTProcessor (const Array<Resolution>& stageResolutions, const Array<double>& crossoverFrequencies)
+    : crossovers (crossoverFrequencies)
+    {
+        jassert (stageResolutions.size() > 0);
+        jassert (crossoverFrequencies.size() == stageResolutions.size() - 1);
+
+        for (int i = 1; i < crossovers.size(); ++i)
+            jassert (crossovers[i] > crossovers[i - 1]);
+
+        for (auto& resolution : stageResolutions)
+        {
+            // make sure you don't want to hop smaller than 1 sample or skip input samples
+            jassert (resolution.hopSize > 0 && resolution.hopSize <= resolution.fftSize);
+
+            auto* stage = stages.add (new Stage());
+            stage->resolution = resolution;
+            stage->fft = planCache->getPlan (resolution.fftSize);
+            stage->workspace = stage->fft->createWorkspace();
+            stage->window.resize ((size_t) resolution.fftSize);
+            stage->bandGains.resize ((size_t) resolution.fftSize + 2);
+
+            maximumFftSize = jmax (maximumFftSize, resolution.fftSize);
+        }
+    }
+
+    virtual ~BasicMultiResolutionFFTProcessor() {}
+
+    int getNumStages() const { return stages.size(); }
+    Resolution getStageResolution (const int stage) const { return stages[stage]->resolution; }
+
+    /** Returns the latency in samples introduced by the processor, which is the same for all stages. */
+    int getLatencyInSamples() const { return maximumFftSize - 1; }
+
+    /** Sets the width of the crossover regions in octaves (default: 1). Has to be called before `prepare()`. */
+    void setCrossoverWidth (const double widthInOctaves)
+    {
+        jassert (widthInOctaves > 0.0);
+        crossoverWidth = widthInOctaves;
+    }
+
+    double getCrossoverWidth() const { return crossoverWidth; }
+
+    /**
+     Sets the number of additional threads which help processing the frames of several stages, which are due at the
+     same time, in parallel. Pass 0 to process all frames on the audio thread (default). Don't call this while
+     `process()` might be running. For the spin time of the workers and its CPU cost, see
+     `BasicOverlappingFFTProcessor::setNumWorkerThreads()`.
+     */
+    void setNumWorkerThreads (const int numWorkerThreads, const double workerSpinTimeInMilliseconds = FrameWorkerPool::defaultSpinTimeInMilliseconds)
+    {
+        jassert (numWorkerThreads >= 0);
+
+        if (numWorkerThreads > 0)
+            workerPool.reset (new FrameWorkerPool (numWorkerThreads, workerSpinTimeInMilliseconds));
+        else
+            workerPool.reset();
+    }
+
+    /** Prepares the processor. All memory is allocated here, `process()` never allocates. */
+    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels)
+    {
+        nChIn = numInputChannels;
+        nChOut = numOutputChannels;
+        const int maxCh = jmax (nChIn, nChOut);
+
+        for (int i = 0; i < stages.size(); ++i)
+        {
+            auto& stage = *stages.getUnchecked (i);
+            const int fftSize = stage.resolution.fftSize;
+
+            createWindow (i, stage.window, stage.resolution);
+            jassert (stage.window.size() == (size_t) fftSize);
+
+            // band gains of the bins, interleaved like the spectra, so they can be applied with one multiplication
+            for (int bin = 0; bin <= fftSize / 2; ++bin)
+            {
+                const double frequency = bin * sampleRate / fftSize;
+                const double upper = i < crossovers.size() ? getLowpassGain (frequency, crossovers[i]) : 1.0;
+                const double lower = i > 0 ? getLowpassGain (frequency, crossovers[i - 1]) : 0.0;
+
+                stage.bandGains[(size_t) (2 * bin)] = (SampleType) (upper - lower);
+                stage.bandGains[(size_t) (2 * bin + 1)] = (SampleType) (upper - lower);
+            }
+
+            // the frame buffer of a stage only holds its own frames, the transforms need 2 * fftSize values per channel
+            stage.buffer.setSize (maxCh, 2 * fftSize);
+            stage.samplesUntilNextFrame = fftSize;
+        }
+
+        // the input history holds the last maximumFftSize samples, which all stages read their frames from
+        const int inputBufferSize = nextPowerOfTwo (maximumFftSize);
+        inputBuffer.setSize (nChIn, inputBufferSize);
+        inputBuffer.clear();
+        inputBufferMask = inputBufferSize - 1;
+
+        int maximumHopSize = 0;
+        for (auto* stage : stages)
+            maximumHopSize = jmax (maximumHopSize, stage->resolution.hopSize);
+
+        // circular overlap-add accumulator of all stages
+        const int outputBufferSize = nextPowerOfTwo (maximumFftSize + maximumHopSize + maximumBlockSize);
+        outputBuffer.setSize (nChOut, outputBufferSize);
+        outputBuffer.clear();
+        outputBufferMask = outputBufferSize - 1;
+
+        dueStages.ensureStorageAllocated (stages.size());
+        inputPosition = 0;
+        outputReadPosition = 0;
+    }
+
+    void process (const dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::ProcessContextNonReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::AudioBlock<const SampleType>& inputBlock, dsp::AudioBlock<SampleType>& outputBlock)
+    {
+        const auto L = (int) inputBlock.getNumSamples();
+        const auto numChIn = jmin (static_cast<int> (inputBlock.getNumChannels()), nChIn);
+        const auto numChOut = jmin (static_cast<int> (outputBlock.getNumChannels()), nChOut);
+        maxNumChannels = jmax (numChIn, numChOut);
+
+        int usedSamples = 0;
+        while (usedSamples < L)
+        {
+            // append as many new samples to the input history as needed for the next frame of any stage
+            int numSamples = L - usedSamples;
+            for (auto* stage : stages)
+                numSamples = jmin (numSamples, stage->samplesUntilNextFrame);
+
+            const int inputWritePosition = (int) (inputPosition & inputBufferMask);
+            const int firstPart = jmin (numSamples, inputBuffer.getNumSamples() - inputWritePosition);
+            const int secondPart = numSamples - firstPart;
+
+            for (int ch = 0; ch < numChIn; ++ch)
+            {
+                const SampleType* src = inputBlock.getChannelPointer (ch) + usedSamples;
+                FloatVectorOperations::copy (inputBuffer.getWritePointer (ch, inputWritePosition), src, firstPart);
+                FloatVectorOperations::copy (inputBuffer.getWritePointer (ch), src + firstPart, secondPart);
+            }
+
+            inputPosition += numSamples;
+            usedSamples += numSamples;
+
+            dueStages.clearQuick();
+            for (int i = 0; i < stages.size(); ++i)
+            {
+                auto& stage = *stages.getUnchecked (i);
+                stage.samplesUntilNextFrame -= numSamples;
+
+                if (stage.samplesUntilNextFrame == 0)
+                {
+                    windowFrame (stage, numChIn);
+                    dueStages.add (i);
+                    stage.samplesUntilNextFrame = stage.resolution.hopSize;
+                }
+            }
+
+            processDueStages();
+
+            // in the order of the stages, so the output doesn't depend on the threads
+            for (int i : dueStages)
+                writeBackFrame (*stages.getUnchecked (i));
+        }
+
+        readOutput (outputBlock, numChOut, L);
+    }
+
+    int getNumInputChannels() const { return nChIn; }
+    int getNumOutputChannels() const { return nChOut; }
+
+private:
+    /**
+     Fills the window of a stage. It's called by `prepare()`. Don't change the size of the window.
+     The default is the one of the OverlappingFFTProcessor, a periodic Hann window compensated for the hopSize.
+     */
+    virtual void createWindow (const int stage, std::vector<SampleType>& windowToFill, const Resolution resolution)
+    {
+        ignoreUnused (stage);
+        BasicOverlappingFFTProcessor<SampleType>::createHannWindow (windowToFill, resolution);
+    }
+
+    /**
+     This method get's called for each frame of each stage. The spectra are the ones of
+     `performRealOnlyForwardTransform (data, true)` with the stage's fftSize (fftSize + 2 values per channel). Afterwards,
+     they are multiplied with the band gains of the stage and transformed back. With worker threads, frames of
+     different stages are processed concurrently, so only touch the data of the given stage.
+     @param stage the index of the stage, see `getStageResolution()`
+     @param spectra the spectra of the frame's channels
+     @param maxNumChannels the max number of channels of `spectra` you should use
+     */
+    virtual void processStageSpectrum (const int stage, AudioBuffer<SampleType>& spectra, const int maxNumChannels)
+    {
+        ignoreUnused (stage, spectra, maxNumChannels);
+    }
+
+    /** Gain of a lowpass at the given crossover frequency, with a raised cosine over crossoverWidth octaves (on a logarithmic frequency axis). */
+    double getLowpassGain (const double frequency, const double crossoverFrequency) const
+    {
+        if (frequency <= 0.0)
+            return 1.0;
+
+        const double position = jlimit (0.0, 1.0, std::log2 (frequency / crossoverFrequency) / crossoverWidth + 0.5);
+        return 0.5 * (1.0 + std::cos (MathConstants<double>::pi * position));
+    }
+
+    struct Stage
+    {
+        Resolution resolution;
+        std::shared_ptr<const FFTBackend<SampleType>> fft;
+        std::unique_ptr<FFTWorkspace> workspace; // a stage is processed by one thread at a time
+        std::vector<SampleType> window;
+        std::vector<SampleType> bandGains;
+        AudioBuffer<SampleType> buffer;
+        int samplesUntilNextFrame = 0;
+        int64 frameStart = 0;
+    };
+
+    /** Copies the last fftSize samples of the shared input history into the stage's buffer (with windowing). */
+    void windowFrame (Stage& stage, const int numChannels)
+    {
+        const int frameSize = stage.resolution.fftSize;
+        const SampleType* frameWindow = stage.window.data();
+        stage.frameStart = inputPosition - frameSize;
+
+        const int frameStart = (int) (stage.frameStart & inputBufferMask);
+        const int firstPart = jmin (frameSize, inputBuffer.getNumSamples() - frameStart);
+        const int secondPart = frameSize - firstPart;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            FloatVectorOperations::multiply (stage.buffer.getWritePointer (ch), inputBuffer.getReadPointer (ch, frameStart), frameWindow, firstPart);
+            FloatVectorOperations::multiply (stage.buffer.getWritePointer (ch, firstPart), inputBuffer.getReadPointer (ch), frameWindow + firstPart, secondPart);
+        }
+
+        // channels without input (e.g. more outputs than inputs) start silent
+        for (int ch = numChannels; ch < stage.buffer.getNumChannels(); ++ch)
+            FloatVectorOperations::clear (stage.buffer.getWritePointer (ch), frameSize);
+    }
+
+    /** Processes the frames of the due stages, in parallel if there are worker threads, and waits until all are done. */
+    void processDueStages()
+    {
+        if (workerPool == nullptr || dueStages.size() < 2)
+        {
+            for (int i = 0; i < dueStages.size(); ++i)
+                stageJob.runTask (i);
+
+            return;
+        }
+
+        workerPool->perform (stageJob, dueStages.size());
+    }
+
+    /**
+     Forward transforms, spectral callback, band gains and inverse transforms of a stage's frame. Like the frequency
+     domain of the OverlappingFFTProcessor, the callback gets all channels of the frame, and all of them are transformed back.
+     */
+    void processStageFrame (const int stageIndex)
+    {
+        auto& stage = *stages.getUnchecked (stageIndex);
+        const int fftSize = stage.resolution.fftSize;
+
+        for (int ch = 0; ch < maxNumChannels; ++ch)
+            stage.fft->performRealOnlyForwardTransform (stage.buffer.getWritePointer (ch), true, stage.workspace.get());
+
+        processStageSpectrum (stageIndex, stage.buffer, maxNumChannels);
+
+        for (int ch = 0; ch < maxNumChannels; ++ch)
+        {
+            SampleType* data = stage.buffer.getWritePointer (ch);
+            FloatVectorOperations::multiply (data, stage.bandGains.data(), fftSize + 2);
+            stage.fft->performRealOnlyInverseTransform (data, stage.workspace.get());
+        }
+    }
+
+    /** Adds the stage's processed frame to the shared output buffer, delayed by the common latency. */
+    void writeBackFrame (const Stage& stage)
+    {
+        const int frameSize = stage.resolution.fftSize;
+        const int writeIndex = (int) ((stage.frameStart + getLatencyInSamples()) & outputBufferMask);
+        const int firstPart = jmin (frameSize, outputBuffer.getNumSamples() - writeIndex);
+        const int secondPart = frameSize - firstPart;
+
+        for (int ch = 0; ch < nChOut; ++ch)
+        {
+            FloatVectorOperations::add (outputBuffer.getWritePointer (ch, writeIndex), stage.buffer.getReadPointer (ch), firstPart);
+            FloatVectorOperations::add (outputBuffer.getWritePointer (ch), stage.buffer.getReadPointer (ch, firstPart), secondPart);
+        }
+    }
+
+    /** Returns the processed samples from outputBuffer and clears them for the upcoming frames. */
+    void readOutput (dsp::AudioBlock<SampleType>& outputBlock, const int numChOut, const int L)
+    {
+        const int readIndex = (int) (outputReadPosition & outputBufferMask);
+        const int firstPart = jmin (L, outputBuffer.getNumSamples() - readIndex);
+        const int secondPart = L - firstPart;
+
+        for (int ch = 0; ch < numChOut; ++ch)
+        {
+            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch), outputBuffer.getReadPointer (ch, readIndex), firstPart);
+            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch) + firstPart, outputBuffer.getReadPointer (ch), secondPart);
+        }
+
+        for (int ch = 0; ch < nChOut; ++ch)
+        {
+            FloatVectorOperations::clear (outputBuffer.getWritePointer (ch, readIndex), firstPart);
+            FloatVectorOperations::clear (outputBuffer.getWritePointer (ch), secondPart);
+        }
+
+        for (int ch = numChOut; ch < (int) outputBlock.getNumChannels(); ++ch)
+            FloatVectorOperations::clear (outputBlock.getChannelPointer (ch), L);
+
+        outputReadPosition += L;
+    }
+
+    struct StageJob : public FrameWorkerPool::Job
+    {
+        StageJob (BasicMultiResolutionFFTProcessor& p) : processor (p) {}
+        void runTask (const int task) override { processor.processStageFrame (processor.dueStages.getUnchecked (task)); }
+        BasicMultiResolutionFFTProcessor& processor;
+    };
+
+    int nChIn = 0;
+    int nChOut = 0;
+    int maxNumChannels = 0;
+    int maximumFftSize = 0;
+
+    SharedResourcePointer<FFTPlanCache<SampleType>> planCache;
+    OwnedArray<Stage> stages;
+    Array<double> crossovers;
+    double crossoverWidth = 1.0;
+
+    AudioBuffer<SampleType> inputBuffer;
+    int inputBufferMask = 0;
+    int64 inputPosition = 0;
+
+    AudioBuffer<SampleType> outputBuffer;
+    int outputBufferMask = 0;
+    int64 outputReadPosition = 0;
+
+    Array<int> dueStages;
+    StageJob stageJob { *this };
+    std::unique_ptr<FrameWorkerPool> workerPool;
+
+    JUCE_DECLARE_NON_COPYABLE (BasicMultiResolutionFFTProcessor)
+};
+
+/** The multi-resolution processor in single precision. */
+using MultiResolutionFFTProcessor = BasicMultiResolutionFFTProcessor<float>;
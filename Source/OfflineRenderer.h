@@ -0,0 +1,310 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "OverlappingFFTProcessor.h"
+#include "FrameWorkerPool.h"
+
+/**
+ Processes whole buffers or files with an OverlappingFFTProcessor (subclass) faster than real time.
+ Instead of feeding `process()` block by block, the frames are taken directly from the input and processed back to
+ back, in batches which are spread over all threads: each thread has its own processor instance, created by the
+ factory passed to the constructor. The processed frames of a batch are then overlap-added in chunks of output
+ samples, also in parallel. Each chunk adds its frames in the order of the real-time path, so the order in which
+ the chunks are processed doesn't matter.
+
+ The output has the same length as the input and has no latency: its sample n is the sample `process()` returns
+ `getLatencyInSamples()` samples later, when it's fed with the input followed by silence. It's the same sample for
+ sample, as long as the frames are processed independently of each other (like the processor's callbacks are meant to),
+ and the real-time path doesn't use amortized scheduling (which transforms channels one by one instead of in batches).
+ Processing which depends on previous frames needs a single thread, in which case all frames are processed in order.
+ The renderer schedules the frames itself, so the processors have to use `FrameScheduling::synchronous`: a background
+ or amortized scheduling would only add its deferral, without taking any load off a thread.
+
+ @code
+ OfflineRenderer<float> renderer ([] { return std::unique_ptr<OverlappingFFTProcessor> (new MyProcessor()); });
+ renderer.process (recording, processedRecording, 48000.0);
+ @endcode
+ */
+template <typename SampleType>
+class OfflineRenderer
+{
+public:
+    using Processor = BasicOverlappingFFTProcessor<SampleType>;
+    using ProcessorFactory = std::function<std::unique_ptr<Processor>()>;
+
+    /** Constructor
+     @param createProcessor creates a processor with the settings to use (resolution, frame domain, ...), it's called
+            once for each thread. The processors have to use `FrameScheduling::synchronous` (the default), the
+            renderer prepares them. Don't attach a SpectrumTap if you use several threads, as the frames would be
+            published concurrently.
+     @param numberOfThreads number of threads processing the frames, including the one calling `process()`
+     */
+    OfflineRenderer (ProcessorFactory createProcessor, const int numberOfThreads = SystemStats::getNumCpus())
+    {
+        jassert (numberOfThreads > 0);
+
+        for (int i = 0; i < jmax (1, numberOfThreads); ++i)
+        {
+            auto* processor = processors.add (createProcessor().release());
+
+            // the renderer schedules the frames itself, return processors with synchronous scheduling
+            jassert (processor->getFrameScheduling() == Processor::FrameScheduling::synchronous);
+            ignoreUnused (processor);
+        }
+
+        if (processors.size() > 1)
+            workerPool.reset (new FrameWorkerPool (processors.size() - 1));
+    }
+
+    int getNumThreads() const { return processors.size(); }
+
+    /** Returns the processor of the first thread, e.g. to read its latency or settings. */
+    Processor& getProcessor() { return *processors.getFirst(); }
+
+    /**
+     Processes a whole buffer. The input and output buffer can be the same.
+     @param output gets resized to the length of the input, its number of channels is the number of output channels
+     @param sampleRate the sample rate the processors are prepared with
+     */
+    void process (const AudioBuffer<SampleType>& input, AudioBuffer<SampleType>& output, const double sampleRate)
+    {
+        const int numSamples = input.getNumSamples();
+        output.setSize (output.getNumChannels(), numSamples, true, false, true);
+
+        render (numSamples, input.getNumChannels(), output.getNumChannels(), sampleRate,
+                [&input] (AudioBuffer<SampleType>& destination, const int64 start, const int numSamplesToRead)
+                {
+                    for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+                        destination.copyFrom (ch, 0, input, ch, (int) start, numSamplesToRead);
+                },
+                [&output] (const AudioBuffer<SampleType>& source, const int64 start, const int numSamplesToWrite)
+                {
+                    for (int ch = 0; ch < output.getNumChannels(); ++ch)
+                        output.copyFrom (ch, (int) start, source, ch, 0, numSamplesToWrite);
+
+                    return true;
+                });
+    }
+
+    /**
+     Streams all samples of a reader through the processors into a writer, with the reader's sample rate.
+     Only a batch of frames is held in memory, so it's suitable for recordings of any length.
+     @returns false if the writer failed
+     */
+    bool process (AudioFormatReader& reader, AudioFormatWriter& writer)
+    {
+        return render (reader.lengthInSamples, (int) reader.numChannels, writer.getNumChannels(), reader.sampleRate,
+                       [this, &reader] (AudioBuffer<SampleType>& destination, const int64 start, const int numSamplesToRead)
+                       {
+                           readFromReader (reader, destination, start, numSamplesToRead);
+                       },
+                       [this, &writer] (const AudioBuffer<SampleType>& source, const int64, const int numSamplesToWrite)
+                       {
+                           return writeToWriter (writer, source, numSamplesToWrite);
+                       });
+    }
+
+private:
+    /**
+     Processes numSamples input samples in batches of frames: `readInput (buffer, start, numSamples)` fills the
+     first samples of the buffer with the input from position start on, `writeOutput (buffer, start, numSamples)`
+     gets the completed output samples from position start on.
+     */
+    template <typename ReadFunction, typename WriteFunction>
+    bool render (const int64 numSamples, const int numInputChannels, const int numOutputChannels, const double sampleRate,
+                 ReadFunction&& readInput, WriteFunction&& writeOutput)
+    {
+        for (auto* processor : processors)
+        {
+            processor->prepare (sampleRate, 1, numInputChannels, numOutputChannels);
+
+            // all processors have to use the same resolution
+            jassert (processor->fftSize == processors.getFirst()->fftSize && processor->hopSize == processors.getFirst()->hopSize);
+        }
+
+        fftSize = processors.getFirst()->fftSize;
+        hopSize = processors.getFirst()->hopSize;
+        nChOut = numOutputChannels;
+
+        // as many frames per batch as fit into the frame store, but at least one per thread
+        const int numThreads = processors.size();
+        const int numFramesPerBatch = jmax (numThreads, jmin (maxFramesPerThread * numThreads, maxFrameStoreSize / jmax (1, nChOut * fftSize)));
+        const int maximumBatchSize = (numFramesPerBatch - 1) * hopSize + fftSize;
+
+        inputSpan.setSize (numInputChannels, maximumBatchSize);
+        accumulator.setSize (nChOut, maximumBatchSize);
+        accumulator.clear();
+        frameStore.setSize (numFramesPerBatch * nChOut, fftSize);
+
+        // all frames starting within the input, the last ones reach into the silence which would flush the real-time path
+        const int64 numFrames = numSamples > 0 ? (numSamples - 1) / hopSize + 1 : 0;
+
+        for (int64 firstFrame = 0; firstFrame < numFrames; firstFrame += numFramesPerBatch)
+        {
+            batchStart = firstFrame * hopSize;
+            numFramesInBatch = (int) jmin ((int64) numFramesPerBatch, numFrames - firstFrame);
+            batchSize = (numFramesInBatch - 1) * hopSize + fftSize;
+
+            const int numInputSamples = (int) jmin ((int64) batchSize, numSamples - batchStart);
+            readInput (inputSpan, batchStart, numInputSamples);
+
+            for (int ch = 0; ch < numInputChannels; ++ch)
+                inputSpan.clear (ch, numInputSamples, batchSize - numInputSamples);
+
+            perform (frameJob, numThreads);
+            perform (overlapAddJob, (batchSize + overlapAddChunkSize - 1) / overlapAddChunkSize);
+
+            // the next batch's frames start after the first numFramesInBatch hops, those samples are complete
+            const int numCompletedSamples = numFramesInBatch * hopSize;
+            if (! writeOutput (accumulator, batchStart, (int) jmin ((int64) numCompletedSamples, numSamples - batchStart)))
+                return false;
+
+            // the tail of the batch's last frames is continued by the next batch
+            const int tailSize = batchSize - numCompletedSamples;
+            for (int ch = 0; ch < nChOut; ++ch)
+            {
+                SampleType* data = accumulator.getWritePointer (ch);
+                std::memmove (data, data + numCompletedSamples, (size_t) tailSize * sizeof (SampleType));
+                FloatVectorOperations::clear (data + tailSize, maximumBatchSize - tailSize);
+            }
+        }
+
+        return true;
+    }
+
+    void perform (FrameWorkerPool::Job& job, const int numTasks)
+    {
+        if (workerPool == nullptr || numTasks < 2)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                job.runTask (i);
+
+            return;
+        }
+
+        workerPool->perform (job, numTasks, jmax (1, numTasks / (2 * processors.size())));
+    }
+
+    /** The processor of the given thread processes every numThreads-th frame of the batch into the frame store. */
+    void processFrames (const int thread)
+    {
+        auto& processor = *processors.getUnchecked (thread);
+
+        for (int frame = thread; frame < numFramesInBatch; frame += processors.size())
+        {
+            processor.processOfflineFrame (inputSpan, frame * hopSize, batchStart + frame * hopSize);
+
+            for (int ch = 0; ch < nChOut; ++ch)
+                frameStore.copyFrom (frame * nChOut + ch, 0, processor.fftInOutBuffer, ch, 0, fftSize);
+        }
+    }
+
+    /** Adds the frames of the batch to a chunk of the accumulator, in the order of the frames. */
+    void overlapAddChunk (const int chunk)
+    {
+        const int chunkStart = chunk * overlapAddChunkSize;
+        const int chunkEnd = jmin (chunkStart + overlapAddChunkSize, batchSize);
+        const int firstFrame = chunkStart < fftSize ? 0 : (chunkStart - fftSize) / hopSize + 1;
+
+        for (int frame = firstFrame; frame < numFramesInBatch && frame * hopSize < chunkEnd; ++frame)
+        {
+            const int frameStart = frame * hopSize;
+            const int start = jmax (chunkStart, frameStart);
+            const int end = jmin (chunkEnd, frameStart + fftSize);
+
+            for (int ch = 0; ch < nChOut; ++ch)
+                FloatVectorOperations::add (accumulator.getWritePointer (ch, start),
+                                            frameStore.getReadPointer (frame * nChOut + ch, start - frameStart), end - start);
+        }
+    }
+
+    void readFromReader (AudioFormatReader& reader, AudioBuffer<float>& destination, const int64 start, const int numSamplesToRead)
+    {
+        reader.read (&destination, 0, numSamplesToRead, start, true, true);
+    }
+
+    void readFromReader (AudioFormatReader& reader, AudioBuffer<double>& destination, const int64 start, const int numSamplesToRead)
+    {
+        conversionBuffer.setSize (destination.getNumChannels(), numSamplesToRead, false, false, true);
+        reader.read (&conversionBuffer, 0, numSamplesToRead, start, true, true);
+
+        for (int ch = 0; ch < destination.getNumChannels(); ++ch)
+            for (int i = 0; i < numSamplesToRead; ++i)
+                destination.setSample (ch, i, (double) conversionBuffer.getSample (ch, i));
+    }
+
+    bool writeToWriter (AudioFormatWriter& writer, const AudioBuffer<float>& source, const int numSamplesToWrite)
+    {
+        return writer.writeFromAudioSampleBuffer (source, 0, numSamplesToWrite);
+    }
+
+    bool writeToWriter (AudioFormatWriter& writer, const AudioBuffer<double>& source, const int numSamplesToWrite)
+    {
+        conversionBuffer.setSize (source.getNumChannels(), numSamplesToWrite, false, false, true);
+
+        for (int ch = 0; ch < source.getNumChannels(); ++ch)
+            for (int i = 0; i < numSamplesToWrite; ++i)
+                conversionBuffer.setSample (ch, i, (float) source.getSample (ch, i));
+
+        return writer.writeFromAudioSampleBuffer (conversionBuffer, 0, numSamplesToWrite);
+    }
+
+    struct FrameJob : public FrameWorkerPool::Job
+    {
+        FrameJob (OfflineRenderer& r) : renderer (r) {}
+        void runTask (const int thread) override { renderer.processFrames (thread); }
+        OfflineRenderer& renderer;
+    };
+
+    struct OverlapAddJob : public FrameWorkerPool::Job
+    {
+        OverlapAddJob (OfflineRenderer& r) : renderer (r) {}
+        void runTask (const int chunk) override { renderer.overlapAddChunk (chunk); }
+        OfflineRenderer& renderer;
+    };
+
+    // the frame store holds at most that many samples, and at most that many frames per thread are processed per batch
+    static constexpr int maxFrameStoreSize = 1 << 22;
+    static constexpr int maxFramesPerThread = 8;
+    static constexpr int overlapAddChunkSize = 1024;
+
+    OwnedArray<Processor> processors;
+    std::unique_ptr<FrameWorkerPool> workerPool;
+    FrameJob frameJob { *this };
+    OverlapAddJob overlapAddJob { *this };
+
+    int fftSize = 0;
+    int hopSize = 0;
+    int nChOut = 0;
+
+    // the current batch: its frames start at batchStart + i * hopSize, its output covers batchSize samples from batchStart on
+    int64 batchStart = 0;
+    int numFramesInBatch = 0;
+    int batchSize = 0;
+
+    AudioBuffer<SampleType> inputSpan;
+    AudioBuffer<SampleType> accumulator;
+    AudioBuffer<SampleType> frameStore;
+    AudioBuffer<float> conversionBuffer;
+
+    JUCE_DECLARE_NON_COPYABLE (OfflineRenderer)
+};
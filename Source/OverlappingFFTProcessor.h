@@ -21,17 +21,150 @@
 /* Changelog
  2019-09-03
     - compatibility to JUCE 5.4.4
+ 2026-10-15
+    - output buffer is now a circular overlap-add accumulator, no more shifting of the output samples
+    - input samples are gathered in a circular history buffer, frames are windowed directly from it
+    - per-channel processFrame() callback, optionally processed in parallel by worker threads
+    - optional background frame scheduling (one hopSize of additional latency), see getLatencyInSamples() and releaseResources()
+    - optional frequency-domain callback processSpectrumInBuffer(), and amortized frame scheduling
+    - arbitrary fftSize and hopSize, non power of 2 transforms use Bluestein's algorithm
+    - setResolution() changes fftSize and hopSize while processing (up to the maximum fftSize passed to prepare()),
+      createWindow() now gets the window and resolution to use as arguments
+    - FFT backends (juce::dsp::FFT, Bluestein, optionally FFTW) behind the FFTBackend interface, with plans shared
+      by all processor instances through the FFTPlanCache, each thread of a processor has its own scratch memory (FFTWorkspace)
+    - split-complex frame domain with processSplitSpectrumInBuffer() and SIMD kernels in SplitComplexBuffer
+    - many channels of small power of 2 transforms are transformed in batches (one channel per SIMD lane), unless
+      another backend is used (FFTW or FFTPlanCache::setFactory())
+    - the default window is a periodic Hann window (perfect reconstruction if fftSize is a multiple of hopSize),
+      frame channels without input are cleared
+    - optional statistics (OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS): durations of the processing stages, frames per
+      process() call and late frames, see getStatistics()
+    - lock-free SpectrumTap, which publishes the magnitude spectra of one channel for displays and analysis threads
+    - templated sample type: BasicOverlappingFFTProcessor<double> processes in double precision, with a SIMD radix-2
+      FFT backend for double, OverlappingFFTProcessor is BasicOverlappingFFTProcessor<float>
+    - OfflineRenderer processes whole buffers or files faster than real time: the frames are processed back to back
+      on all cores, without latency, with the same output as process()
+    - analysis and synthesis window pairs with createWindows(), and a low-latency mode with asymmetric low-delay windows
+      (setSynthesisWindowLength()), in which the latency only depends on the length of the synthesis window
+    - MultiResolutionFFTProcessor: several stages with their own resolution for different frequency bands, which share
+      one input history and one overlap-add output buffer, combined with crossovers in the frequency domain
+    - partitioned convolution (uniform and non-uniform) with a frequency-domain delay line, optional zero latency and
+      lock-free impulse response changes, see PartitionedConvolution.h; the synthesis window can be as short as the hopSize
+    - matrix frame domain for MIMO processing: input and output spectra in separate buffers, only the input channels are
+      transformed forward and only the output channels back, with a cache-blocked per-bin complex matrix kernel
+    - optional activity detection (peak or RMS with a hold time, see setActivityDetection()): the frames of silent input
+      channels are skipped, isChannelActive() tells the callbacks which channels to process
+    - smaller per-instance footprint: windows (WindowCache) and batched transforms are shared by all instances, the
+      audio buffers are packed into one aligned block of the minimum size, see getMemoryFootprintBytes()
+    - spectral history (setSpectralHistoryLength()): a preallocated ring of the input spectra of the last frames, which
+      the spectral callbacks access with getPastSpectra(), advanced by swapping buffers instead of copying
+    - frame parameters (setNumFrameParameters()): lock-free changes from any thread or sample-accurate events from the
+      audio thread, the callbacks get a snapshot interpolated to the centre of each frame with getFrameParameter()
  */
 
 #pragma once
-#include "../JuceLibraryCode/JuceHeader.h"
+#include <JuceHeader.h>
+#include "FrameWorkerPool.h"
+#include "FFTBackend.h"
+#include "SplitComplexBuffer.h"
+#include "BatchedFFT.h"
+#include "ProcessorStatistics.h"
+#include "SpectrumTap.h"
+#include "WindowCache.h"
+#include "FrameParameters.h"
+
+template <typename SampleType>
+class OfflineRenderer;
+
+/** The declarations of BasicOverlappingFFTProcessor which don't depend on the sample type. */
+class OverlappingFFTProcessorBase
+{
+public:
+    /** fftSize and hopSize in samples, neither of them has to be a power of 2. */
+    struct Resolution
+    {
+        int fftSize;
+        int hopSize;
+    };
+
+    /** Defines on which thread the frames are processed. */
+    enum class FrameScheduling
+    {
+        synchronous, /**< frames are processed within `process()` (default) */
+        background, /**< frames are handed to a background thread, this adds one hopSize (the maximum passed to `prepare()`) of latency, but the audio thread only has to window and overlap-add */
+        amortized /**< the transforms and the spectral callback of a frame are spread across the host blocks of the following hop, this adds one hopSize (the maximum passed to `prepare()`) of latency. Requires a frame domain other than `FrameDomain::time`. */
+    };
+
+    /** Defines which callback processes the frames. */
+    enum class FrameDomain
+    {
+        time, /**< `processFrameInBuffer()` gets the windowed time-domain frames (default) */
+        frequency, /**< the processor transforms the frames and calls `processSpectrumInBuffer()` with their spectra */
+        splitComplex, /**< the processor transforms the frames and calls `processSplitSpectrumInBuffer()` with their spectra in `spectrumBuffer` */
+        matrix /**< the processor transforms the input channels into `inputSpectra`, `processMatrixSpectra()` computes the output channels' spectra in `outputSpectra` */
+    };
+
+    /** Defines how the activity of the input channels is detected, see `setActivityDetection()`. */
+    enum class ActivityDetection
+    {
+        off, /**< all channels are processed (default) */
+        peak, /**< the peak level of the input samples */
+        rms /**< the RMS level of the input samples */
+    };
+};
 
 /**
  This processor takes care of buffering input and output samples for your FFT processing.
- With fttSizeAsPowerOf2 and hopSizeDividerAsPowerOf2 the fftSize and hopSize can be specifiec.
+ With fttSizeAsPowerOf2 and hopSizeDividerAsPowerOf2 the fftSize and hopSize can be specifiec,
+ or with a `Resolution` for arbitrary sizes (e.g. 960 samples with a hopSize of 360).
  Inherit from this class and override the processFrameInBuffer() function in order to
  implement your processing. You can also override the `createWindow()` method to use
- another window (default: Hann window).
+ another window (default: Hann window), or `createWindows()` for a pair of analysis and synthesis windows.
+
+ If your processing treats each channel independently, override `processFrame()` instead, which
+ gets called for each channel of the frame. Those calls can be spread over several threads by
+ calling `setNumWorkerThreads()`, which helps for high channel counts (e.g. higher order Ambisonics).
+ With `setFrameScheduling (FrameScheduling::background)` the frames are processed on a background thread,
+ which flattens the CPU load of the audio thread at the cost of one additional hop of latency. The thread is then
+ stopped with `releaseResources()` before the processor is destroyed, e.g. in the destructor of the subclass.
+ Report `getLatencyInSamples()` to the host.
+
+ With `setFrameDomain (FrameDomain::frequency)` the processor takes care of the forward and inverse
+ transforms and you only override `processSpectrumInBuffer()`. In that case, the work of a frame can also
+ be spread evenly across the host blocks within one hop with `FrameScheduling::amortized`.
+ `FrameDomain::splitComplex` hands the spectra over as separate, aligned arrays of real and imaginary parts
+ in `spectrumBuffer` instead, see `processSplitSpectrumInBuffer()` and the kernels of `SplitComplexBuffer`.
+ If the output channels are mixtures of the input channels (e.g. beamforming, Ambisonics decoding or upmixing), use
+ `FrameDomain::matrix`: only the input channels are transformed, into `inputSpectra`, and only the output channels are
+ transformed back, from `outputSpectra`, which are filled by `processMatrixSpectra()`, e.g. with the per-bin complex
+ matrix kernel `SplitComplexBuffer::setToMatrixProduct()`.
+ For many channels of small power of 2 transforms, the processor transforms several channels at once, one per SIMD lane
+ (with the default FFT backend, see `FFTPlanCache::isDefaultPowerOfTwoBackend()`).
+ Processing which needs past frames (phase vocoders, noise estimators, transient detectors) can keep the input spectra
+ of the last frames with `setSpectralHistoryLength()`, and read them with `getPastSpectra()`.
+ Parameters of the processing can be automated per frame with `setNumFrameParameters()`: the callbacks read them with
+ `getFrameParameter()`, interpolated to the centre of the current frame.
+
+ The resolution can be changed while processing with `setResolution()`, as long as the fftSize doesn't exceed
+ the maximum fftSize passed to `prepare()`. The switch is crossfaded, and the latency stays the same.
+ The transforms are done by an `FFTBackend` from the process-wide `FFTPlanCache`, so all instances with
+ the same fftSize share their plan. Define OVERLAPPINGFFTPROCESSOR_USE_FFTW=1 to use FFTW, or plug in
+ another library with `FFTPlanCache::setFactory()`. The windows are shared in the same way through the `WindowCache`,
+ and the audio buffers of an instance are packed into one aligned block, `getMemoryFootprintBytes()` returns its size.
+ Define OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS=1 to measure the processing stages in real-time, see `getStatistics()`.
+ A `SpectrumTap` attached with `setSpectrumTap()` receives the magnitude spectra of the frames, e.g. for a spectrogram.
+ For offline processing of whole buffers or files, use the `OfflineRenderer` instead of `process()`.
+ To process frequency bands with different resolutions, use the `MultiResolutionFFTProcessor` instead.
+ For convolution with long impulse responses, see `UniformPartitionedConvolution` and `PartitionedConvolution`.
+ For sessions with many mostly silent channels, `setActivityDetection()` skips the frames of silent input channels.
+ The latency of `fftSize - 1` samples can be reduced to a few hops with `setSynthesisWindowLength()`, which uses
+ asymmetric analysis and synthesis windows with a short synthesis window at the end of the frames.
+ `fftSize`, `hopSize`, `window` (the analysis window) and `fft` always refer to the frame which is currently processed.
+ They belong to the thread running the frame callbacks (with background scheduling, the background thread), so only
+ use them within the callbacks.
+
+ SampleType is float (`OverlappingFFTProcessor`) or double (`BasicOverlappingFFTProcessor<double>`). Double precision
+ processors use double throughout: buffers, windows, transforms (RadixTwoFFTBackend, Bluestein or FFTW) and kernels.
 
  @code
  class MyProcessor : public OverlappingFFTProcessor
@@ -55,193 +188,587 @@
      }
  };
 
+ class MyPerChannelProcessor : public OverlappingFFTProcessor
+ {
+ public:
+     MyPerChannelProcessor () : OverlappingFFTProcessor (12, 2) { setNumWorkerThreads (3); }
+     ~MyPerChannelProcessor() {}
+
+ private:
+     void processFrame (const int channel, float* data) override
+     {
+         fft.performRealOnlyForwardTransform (data, true);
+         FloatVectorOperations::clear (data + fftSize / 2, fftSize / 2); // clear high frequency content
+         fft.performRealOnlyInverseTransform (data);
+     }
+ };
+
  */
-class OverlappingFFTProcessor
+template <typename SampleType>
+class BasicOverlappingFFTProcessor : public OverlappingFFTProcessorBase
 {
 public:
     /** Constructor
      @param fftSizeAsPowerOf2 defines the fftSize as a power of 2: fftSize = 2^fftSizeAsPowerOf2
      @param hopSizeDividerAsPowerOf2 defines the hopSize as a fraction of fftSize: hopSize = fftSize / (2^hopSizeDivider)
      */
-    OverlappingFFTProcessor (const int fftSizeAsPowerOf2, const int hopSizeDividerAsPowerOf2 = 1)
-    : fft (fftSizeAsPowerOf2), fftSize (1 << fftSizeAsPowerOf2), hopSize (fftSize >> hopSizeDividerAsPowerOf2)
+    BasicOverlappingFFTProcessor (const int fftSizeAsPowerOf2, const int hopSizeDividerAsPowerOf2 = 1)
+    : BasicOverlappingFFTProcessor (Resolution { 1 << fftSizeAsPowerOf2, (1 << fftSizeAsPowerOf2) >> hopSizeDividerAsPowerOf2 })
     {
         // make sure you have at least an overlap of 50%
         jassert (hopSizeDividerAsPowerOf2 > 0);
 
         // make sure you don't want to hop smaller than 1 sample
         jassert (hopSizeDividerAsPowerOf2 <= fftSizeAsPowerOf2);
+    }
+
+    /** Constructor for arbitrary sizes, e.g. `OverlappingFFTProcessor (Resolution { 960, 360 })`. Without FFTW, sizes other than powers of 2 use Bluestein's algorithm for the transforms.
+     @param resolution fftSize and hopSize in samples
+     */
+    BasicOverlappingFFTProcessor (const Resolution resolution)
+    : fftSize (resolution.fftSize), hopSize (resolution.hopSize), maximumFftSize (resolution.fftSize), deferredHopSize (resolution.hopSize)
+    {
+        // make sure you don't want to hop smaller than 1 sample or skip input samples
+        jassert (hopSize > 0 && hopSize <= fftSize);
 
         DBG ("Overlapping FFT Processor created with fftSize: " << fftSize << " and hopSize: " << hopSize);
 
-        // create window
-        window.resize (fftSize);
-        createWindow();
+        activeStream.configuration = createConfiguration (resolution);
+        setFrameMembers (*activeStream.configuration);
+    }
+
+    virtual ~BasicOverlappingFFTProcessor()
+    {
+        // the background thread is still running, and might have called the callbacks of the destroyed subclass:
+        // call releaseResources() before the processor is destroyed, e.g. in the destructor of your subclass
+        jassert (! backgroundThread.isThreadRunning());
+        backgroundThread.stopThread (1000);
+    }
+
+    /**
+     Stops the background thread, which `prepare()` starts with `FrameScheduling::background`. It has to be called
+     before the processor is destroyed, as the thread calls the callbacks of the subclass: the destructor of the
+     subclass (or the owner of the processor, e.g. in `AudioProcessor::releaseResources()`) calls it. Call `prepare()`
+     again before the next `process()` call.
+     */
+    void releaseResources()
+    {
+        backgroundThread.stopThread (1000);
+    }
+
+    /**
+     Sets the frame scheduling. Has to be called before `prepare()`.
+     In background mode, `processFrameInBuffer()` is called from a dedicated thread, so call `releaseResources()` before
+     the processor is destroyed, e.g. in the destructor of your subclass.
+     */
+    void setFrameScheduling (const FrameScheduling newScheduling)
+    {
+        backgroundThread.stopThread (1000);
+        scheduling = newScheduling;
+    }
+
+    FrameScheduling getFrameScheduling() const { return scheduling; }
+
+    /** Sets the frame domain. Has to be called before `prepare()`. */
+    void setFrameDomain (const FrameDomain newDomain)
+    {
+        domain = newDomain;
+    }
+
+    FrameDomain getFrameDomain() const { return domain; }
+
+    /**
+     Returns the latency in samples introduced by the processor. It's based on the maximum fftSize (or the
+     synthesis window length in low-latency mode), so it doesn't change with `setResolution()`. Subclasses which
+     add a path with less latency to the frames' output (e.g. the time-domain taps of a convolution) override it.
+     */
+    virtual int getLatencyInSamples() const
+    {
+        return getFrameLatencyInSamples();
+    }
+
+    /**
+     Enables the low-latency mode: the synthesis windows are zero except for the last `length` samples of the frames,
+     so the latency is reduced to `length - 1` samples (plus the deferral of the frame scheduling), independent of the
+     fftSize. By default, `createWindows()` then creates asymmetric low-delay windows, see `createLowDelayWindows()`:
+     the frequency resolution of the long analysis window is kept, e.g. fftSize 4096 with a hopSize of 256 and a
+     synthesis window of 512 samples has 511 samples of latency instead of 4095.
+     The length has to be at least the hopSize (twice the hopSize for the low-delay windows) and at most the fftSize,
+     of all resolutions used with `setResolution()`. Has to be called before `prepare()`, pass 0 to turn it off (default).
+     */
+    void setSynthesisWindowLength (const int length)
+    {
+        const auto& resolution = activeStream.configuration->resolution;
+        jassert (length == 0 || (length >= resolution.hopSize && length <= resolution.fftSize));
+        synthesisWindowLength = length;
+    }
+
+    int getSynthesisWindowLength() const { return synthesisWindowLength; }
+
+    /**
+     Enables skipping silent input channels. The level of each input channel is measured for each host block (split at
+     the frame boundaries), a channel is active as long as its level exceeded the threshold within the hold time.
+     The frames of inactive channels aren't windowed, transformed, processed or added to the output, their data in
+     `fftInOutBuffer` (and the split-complex spectra) is zero, see `isChannelActive()`. This assumes that each output
+     channel only depends on the input channel with the same index, and that silent frames stay silent. In
+     `FrameDomain::matrix`, only the forward transforms of inactive inputs are skipped.
+     Has to be called before `prepare()`.
+     @param detection peak or RMS level, or off (default)
+     @param threshold the linear level a channel has to exceed to be active, 0 (default) only skips digital silence
+     @param holdTimeInSamples how long a channel stays active after its level fell below the threshold, at least the maximum
+            fftSize, so the frames which still contain some of its signal are processed and their overlap-add tail is complete.
+            Use a longer hold time, if your processing has a longer tail (e.g. a reverb).
+     */
+    void setActivityDetection (const ActivityDetection detection, const SampleType threshold = 0, const int holdTimeInSamples = 0)
+    {
+        jassert (threshold >= 0 && holdTimeInSamples >= 0);
+
+        activityDetection = detection;
+        activityThreshold = threshold;
+        activityHoldTime = holdTimeInSamples;
+    }
+
+    ActivityDetection getActivityDetection() const { return activityDetection; }
+
+    /**
+     Keeps the input spectra of the last frames, for processing which depends on past frames (e.g. phase vocoders,
+     noise estimation or transient detection). The spectral callbacks access them with `getPastSpectra()` in constant
+     time. The history is a preallocated ring of split-complex buffers: after each frame, the buffer holding the
+     frame's spectra is swapped into the ring, in exchange for the oldest one, so the spectra aren't copied around.
+     Only for the spectral frame domains. Has to be called before `prepare()`, pass 0 to turn it off (default).
+     @param numPastFrames the number of past frames to keep
+     */
+    void setSpectralHistoryLength (const int numPastFrames)
+    {
+        jassert (numPastFrames >= 0);
+        spectralHistoryLength = numPastFrames;
+    }
+
+    int getSpectralHistoryLength() const { return spectralHistoryLength; }
+
+    /**
+     Sets up parameters for the frame callbacks, which read them with `getFrameParameter()`: one snapshot per frame,
+     interpolated to the centre of the frame, so the automation is smooth for large host blocks as well as for frames
+     within a block. Change them with `setFrameParameter()` from any thread, or sample-accurately with
+     `addFrameParameterEvent()` on the audio thread, see FrameParameters. Has to be called before `prepare()`.
+     @param numParameters number of parameters, 0 (default) for none
+     @param maximumNumEventsPerBlock maximum number of `addFrameParameterEvent()` calls before each `process()` call
+     @param maximumRampLength number of samples a `setFrameParameter()` change ramps over, and the maximum an event ramps
+            over from the previous change, 0 (default) for steps
+     */
+    void setNumFrameParameters (const int numParameters, const int maximumNumEventsPerBlock = 64, const int maximumRampLength = 0)
+    {
+        frameParameters.setNumParameters (numParameters, maximumNumEventsPerBlock, maximumRampLength);
+    }
+
+    int getNumFrameParameters() const { return frameParameters.getNumParameters(); }
+
+    /**
+     Sets a frame parameter from any thread (e.g. from a parameter listener), without locking. The audio thread picks
+     it up at the start of its next `process()` call, and ramps to it over the ramp length passed to `setNumFrameParameters()`,
+     up to the first sample of that call.
+     */
+    void setFrameParameter (const int index, const float value) noexcept
+    {
+        frameParameters.setValue (index, value);
+    }
 
-        // don`t change the size of the window during createWindow()!
-        jassert (window.size() == fftSize);
+    /**
+     Changes a frame parameter at a sample of the next `process()` call, e.g. for host automation or MIDI controllers.
+     Only call it from the audio thread before `process()`, in the order of the samples. The offset has to be less than
+     the number of samples of that call.
+     */
+    void addFrameParameterEvent (const int index, const float value, const int sampleOffset) noexcept
+    {
+        frameParameters.addEvent (index, value, sampleOffset);
     }
-    
-    virtual ~OverlappingFFTProcessor() {}
 
+    /** Returns the largest fftSize which can be used with `setResolution()`. */
+    int getMaximumFftSize() const { return maximumFftSize; }
+
+    /** Returns the largest hopSize the deferral of the background and amortized frame scheduling was reserved for. */
+    int getMaximumHopSize() const { return deferredHopSize; }
+
+    /**
+     Changes fftSize and hopSize while processing. Call it from any thread but the audio thread (it creates the
+     window and the FFT), not concurrently with `prepare()`. The audio thread picks up the new resolution at its
+     next frame boundary without allocating or locking, and crossfades from the old to the new resolution
+     within half of the smaller fftSize. Further calls during a crossfade are queued, only the last one is used.
+     @param newFftSize the new fftSize, must not be larger than the maximum fftSize passed to `prepare()`
+     @param newHopSize the new hopSize. With background or amortized scheduling, it shouldn't be larger than the maximum
+            hopSize passed to `prepare()`, as the frames only have that deferral to be processed in: larger hops make
+            the audio thread wait for the background thread, or finish the amortized frames at once.
+     @returns false if the resolution can't be used
+     */
+    bool setResolution (const int newFftSize, const int newHopSize)
+    {
+        // make sure you don't want to hop smaller than 1 sample or skip input samples
+        jassert (newHopSize > 0 && newHopSize <= newFftSize);
+
+        // the buffers were allocated for at most getMaximumFftSize(), pass a larger one to prepare()
+        jassert (newFftSize <= maximumFftSize);
+
+        // in low-latency mode, the synthesis window has to fit into the frames and cover at least one hop
+        jassert (synthesisWindowLength == 0 || (newFftSize >= synthesisWindowLength && newHopSize <= synthesisWindowLength));
+
+        // the deferral was reserved for at most getMaximumHopSize(), pass a larger one to prepare()
+        jassert (scheduling == FrameScheduling::synchronous || newHopSize <= deferredHopSize);
+
+        if (newHopSize <= 0 || newHopSize > newFftSize || newFftSize > maximumFftSize)
+            return false;
+
+        if (synthesisWindowLength > 0 && (newFftSize < synthesisWindowLength || newHopSize > synthesisWindowLength))
+            return false;
+
+        deleteRetiredConfigurations();
+
+        auto* newConfiguration = createConfiguration ({ newFftSize, newHopSize });
+
+        // a configuration which hasn't been picked up by the audio thread yet can be deleted right away
+        if (auto* replacedConfiguration = pendingConfiguration.exchange (newConfiguration))
+            configurations.removeObject (replacedConfiguration);
+
+        return true;
+    }
 
     void reset() {}
 
-    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels)
+    /**
+     Prepares the processor. All memory is allocated here, `process()` never allocates.
+     @param maximumFftSizeToUse the largest fftSize you want to use with `setResolution()` later on, the buffers
+            and the latency are based on it. Pass 0 (default) to use the current fftSize.
+     @param maximumHopSizeToUse the largest hopSize you want to use with `setResolution()` later on, the deferral of the
+            background and amortized scheduling (and so their latency) is based on it. Pass 0 (default) to use the current hopSize.
+     */
+    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels,
+                  const int maximumFftSizeToUse = 0, const int maximumHopSizeToUse = 0)
     {
+        backgroundThread.stopThread (1000);
+
+        // nothing is running anymore: a pending resolution takes effect right away, and all other configurations can go
+        if (auto* nextConfiguration = pendingConfiguration.exchange (nullptr))
+            activeStream.configuration = nextConfiguration;
+
+        for (int i = configurations.size(); --i >= 0;)
+            if (configurations.getUnchecked (i) != activeStream.configuration)
+                configurations.remove (i);
+
+        auto& configuration = *activeStream.configuration;
+        configuration.numFramesInFlight = 0;
+
+        // now, the windows of a subclass are used
+        fillWindows (configuration);
+
+        maximumFftSize = jmax (maximumFftSizeToUse, configuration.resolution.fftSize);
+        deferredHopSize = jmax (maximumHopSizeToUse, configuration.resolution.hopSize);
+
+        // a hop can't be larger than the frames
+        jassert (deferredHopSize <= maximumFftSize);
+
+        if (spectrumTap != nullptr)
+        {
+            spectrumTap->prepare (sampleRate, maximumFftSize);
+            tapMagnitudes.calloc (2 * (size_t) maximumFftSize);
+        }
+
+        if (domain == FrameDomain::splitComplex)
+            spectrumBuffer.setSize (jmax (numInputChannels, numOutputChannels), maximumFftSize / 2 + 1);
+        else
+            spectrumBuffer.setSize (0, 0);
+
+        if (domain == FrameDomain::matrix)
+        {
+            inputSpectra.setSize (numInputChannels, maximumFftSize / 2 + 1);
+            outputSpectra.setSize (numOutputChannels, maximumFftSize / 2 + 1);
+        }
+        else
+        {
+            inputSpectra.setSize (0, 0);
+            outputSpectra.setSize (0, 0);
+        }
+
+        // the spectral history needs the transforms of the processor
+        jassert (spectralHistoryLength == 0 || domain != FrameDomain::time);
+        prepareSpectralHistory (domain == FrameDomain::matrix ? numInputChannels : jmax (numInputChannels, numOutputChannels));
+
+        setFrameMembers (configuration);
+
         nChIn = numInputChannels;
         nChOut = numOutputChannels;
-        const auto maxCh = jmax (nChIn, nChOut);
 
         const int bufferSize = maximumBlockSize;
 
-        notYetUsedAudioData.setSize (nChIn, fftSize - 1);
-        fftInOutBuffer.setSize (maxCh, 2 * fftSize);
+        // the input buffer holds the history of the last fftSize input samples, frames are read directly from it
+        const int inputBufferSize = nextPowerOfTwo (maximumFftSize);
+        inputBufferMask = inputBufferSize - 1;
 
-        const int k = floor (1.0f + ((float) (bufferSize - 1)) / hopSize);
-        const int M = k * hopSize + (fftSize - hopSize);
+        // all channels start inactive, they haven't had any signal yet
+        lastActivePositions.malloc ((size_t) nChIn);
+        for (int ch = 0; ch < nChIn; ++ch)
+            lastActivePositions[ch] = std::numeric_limits<int64>::min() / 2;
+
+        activityHoldLength = jmax (activityHoldTime, maximumFftSize);
+        frameActivity.calloc ((size_t) nChIn);
+
+        batchedChannels.calloc ((size_t) jmax (nChIn, nChOut));
+        batchedChannelData.calloc ((size_t) jmax (nChIn, nChOut));
+
+        frameParameters.prepare (maximumFftSize, maximumBlockSize);
+        frameParameterSnapshot.calloc ((size_t) frameParameters.getNumParameters());
+
+        // the output buffer is used as a circular overlap-add accumulator: a frame is added up to the latency
+        // ahead of the input position, and the samples of one host block haven't been read yet
+        const int outputBufferSize = nextPowerOfTwo (getFrameLatencyInSamples() + 1 + bufferSize);
+        outputBufferMask = outputBufferSize - 1;
+
+        outputReadPosition = 0;
+
+        backgroundFrames.clear();
+        if (scheduling == FrameScheduling::background)
+        {
+            // enough frames for the deferral and one host block, plus one frame which is written back,
+            // twice, as two resolutions are processed during a crossfade
+            const int frameHopSize = configuration.resolution.hopSize;
+            const int numFrames = 2 * ((bufferSize + deferredHopSize + frameHopSize - 1) / frameHopSize + 1);
+            for (int i = 0; i < numFrames; ++i)
+            {
+                auto* frame = backgroundFrames.add (new BackgroundFrame());
+                frame->activeChannels.calloc ((size_t) nChIn);
+                frame->parameters.calloc ((size_t) frameParameters.getNumParameters());
+            }
 
-        outputBuffer.setSize (nChIn, M + bufferSize - 1); // not sure if (bufferSize - 1) could be too much, but it's working like a charm... so.. whatever...
-        outputBuffer.clear();
+            numFramesSubmitted = 0;
+            numFramesProcessed = 0;
+            numFramesWrittenBack = 0;
+        }
 
-        int offset = 0;
-        while (offset < fftSize)
-            offset += bufferSize;
+        allocateBuffers (inputBufferSize, outputBufferSize);
 
-        outputOffset = offset - bufferSize;
+        if (scheduling == FrameScheduling::background)
+            backgroundThread.startThread (8);
 
-        outputOffset = fftSize - 1;
+        // amortized scheduling splits the frame into tasks, which only works if we do the transforms
+        jassert (scheduling != FrameScheduling::amortized || domain != FrameDomain::time);
+        numPendingFrameTasks = 0;
 
-        notYetUsedAudioDataCount = 0;
+        inputPosition = 0;
+        // the first frame ends after the pre-roll, the input history before it is silent
+        jassert (preRollLength < configuration.resolution.fftSize);
+        activeStream.samplesUntilNextFrame = configuration.resolution.fftSize - preRollLength;
+        activeStream.endPosition = std::numeric_limits<int64>::max();
+        activeStream.fade = Fade();
+        fadingStream = Stream();
     }
 
 
-    void process (const dsp::ProcessContextReplacing<float>& context)
+    void process (const dsp::ProcessContextReplacing<SampleType>& context)
     {
         process (context.getInputBlock(), context.getOutputBlock());
     }
 
-    void process (const dsp::ProcessContextNonReplacing<float>& context)
+    void process (const dsp::ProcessContextNonReplacing<SampleType>& context)
     {
         process (context.getInputBlock(), context.getOutputBlock());
     }
 
-    void process (const dsp::AudioBlock<const float>& inputBlock, dsp::AudioBlock<float>& outputBlock)
+    void process (const dsp::AudioBlock<const SampleType>& inputBlock, dsp::AudioBlock<SampleType>& outputBlock)
     {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (process);
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.numFramesInProcessCall = 0;)
+
         const auto L = (int) inputBlock.getNumSamples();
         const auto numChIn = jmin (static_cast<int> (inputBlock.getNumChannels()), nChIn);
         const auto numChOut = jmin (static_cast<int> (outputBlock.getNumChannels()), nChOut);
         const auto maxNumChannels = jmax (numChIn, numChOut);
 
-        const int initialNotYetUsedAudioDataCount = notYetUsedAudioDataCount;
-        int notYetUsedAudioDataOffset = 0;
+        frameParameters.beginBlock (inputPosition, L);
+
         int usedSamples = 0;
+        while (usedSamples < L)
+        {
+            // append as many new samples to the input history as needed for the next frame
+            int numSamples = jmin (L - usedSamples, activeStream.samplesUntilNextFrame);
+            if (fadingStream.configuration != nullptr)
+                numSamples = jmin (numSamples, fadingStream.samplesUntilNextFrame);
 
+            const int inputWritePosition = (int) (inputPosition & inputBufferMask);
+            const int firstPart = jmin (numSamples, inputBuffer.getNumSamples() - inputWritePosition);
+            const int secondPart = numSamples - firstPart;
 
-        // we've got some left overs, so let's use them together with the new samples
-        while (notYetUsedAudioDataCount > 0 && notYetUsedAudioDataCount + L >= fftSize)
-        {
-            // copy not yet used data into fftInOut buffer (with hann windowing)
             for (int ch = 0; ch < numChIn; ++ch)
             {
-                FloatVectorOperations::multiply (fftInOutBuffer.getWritePointer (ch), // destination
-                                                 notYetUsedAudioData.getReadPointer (ch, notYetUsedAudioDataOffset), // source 1 (audio data)
-                                                 window.data(), // source 2 (window)
-                                                 notYetUsedAudioDataCount // number of samples
-                                                );
-
-                // fill up fftInOut buffer with new data (with hann windowing)
-                FloatVectorOperations::multiply (fftInOutBuffer.getWritePointer (ch, notYetUsedAudioDataCount), // destination
-                                                 inputBlock.getChannelPointer (ch), // source 1 (audio data)
-                                                 window.data() + notYetUsedAudioDataCount, // source 2 (window)
-                                                 fftSize - notYetUsedAudioDataCount // number of samples
-                                                );
+                const SampleType* src = inputBlock.getChannelPointer (ch) + usedSamples;
+                FloatVectorOperations::copy (inputBuffer.getWritePointer (ch, inputWritePosition), src, firstPart);
+                FloatVectorOperations::copy (inputBuffer.getWritePointer (ch), src + firstPart, secondPart);
             }
 
-            // process frame and buffer output
-            processFrameInBuffer (maxNumChannels);
-            writeBackFrame();
+            inputPosition += numSamples;
 
-            notYetUsedAudioDataOffset += hopSize;
-            notYetUsedAudioDataCount -= hopSize;
-        }
-        
-        if (notYetUsedAudioDataCount > 0) // not enough new input samples to use all of the previous data
-        {
-            for (int ch = 0; ch < numChIn; ++ch)
-            {
-                FloatVectorOperations::copy (notYetUsedAudioData.getWritePointer (ch),
-                                             notYetUsedAudioData.getReadPointer (ch, initialNotYetUsedAudioDataCount - notYetUsedAudioDataCount),
-                                             notYetUsedAudioDataCount);
-                FloatVectorOperations::copy (notYetUsedAudioData.getWritePointer (ch, notYetUsedAudioDataCount),
-                                             inputBlock.getChannelPointer (ch) + usedSamples,
-                                             L);
-            }
-            notYetUsedAudioDataCount += L;
-        }
-        else  // all of the previous data used
-        {
-            int dataOffset = - notYetUsedAudioDataCount;
-            
-            while (L - dataOffset >= fftSize)
-            {
-                for (int ch = 0; ch < numChIn; ++ch)
-                {
-                    FloatVectorOperations::multiply (fftInOutBuffer.getWritePointer (ch),
-                                                     inputBlock.getChannelPointer (ch) + dataOffset,
-                                                     window.data(), fftSize);
-                }
-                processFrameInBuffer (maxNumChannels);
-                writeBackFrame();
+            if (activityDetection != ActivityDetection::off)
+                measureActivity (inputBlock, usedSamples, numSamples, numChIn);
 
-                dataOffset += hopSize;
-            }
-            
-            int remainingSamples = L - dataOffset;
-            if (remainingSamples > 0)
-            {
-                for (int ch = 0; ch < numChIn; ++ch)
-                {
-                    FloatVectorOperations::copy (notYetUsedAudioData.getWritePointer (ch),
-                                                 inputBlock.getChannelPointer (ch) + dataOffset,
-                                                 L - dataOffset);
-                }
-            }
-            notYetUsedAudioDataCount = remainingSamples;
-        }
+            activeStream.samplesUntilNextFrame -= numSamples;
+            if (fadingStream.configuration != nullptr)
+                fadingStream.samplesUntilNextFrame -= numSamples;
+            usedSamples += numSamples;
 
+            if (scheduling == FrameScheduling::amortized)
+                runPendingFrameTasks (numSamples);
 
-        // return processed samples from outputBuffer
-        const int shiftStart = L;
-        int shiftL = outputOffset + fftSize - hopSize - L;
+            if (activeStream.samplesUntilNextFrame == 0 && fadingStream.configuration == nullptr)
+                switchToPendingConfiguration();
 
-        const int tooMuch = shiftStart + shiftL - outputBuffer.getNumSamples();
-        if (tooMuch > 0)
-            shiftL -= tooMuch;
+            if (fadingStream.configuration != nullptr && fadingStream.samplesUntilNextFrame == 0)
+                advanceStream (fadingStream, numChIn, maxNumChannels);
 
-        for (int ch = 0; ch < numChOut; ++ch)
-        {
-            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch), outputBuffer.getReadPointer (ch), L);
-            FloatVectorOperations::copy (outputBuffer.getWritePointer (ch), outputBuffer.getReadPointer (ch, shiftStart), shiftL);
+            if (activeStream.samplesUntilNextFrame == 0)
+                advanceStream (activeStream, numChIn, maxNumChannels);
         }
 
-        for (int ch = numChOut; ch < outputBlock.getNumChannels(); ++ch)
-            FloatVectorOperations::clear (outputBlock.getChannelPointer (ch), L);
+        if (scheduling == FrameScheduling::background)
+            writeBackBackgroundFrames (outputReadPosition + L);
+        else if (scheduling == FrameScheduling::amortized && numPendingFrameTasks > 0 && getFirstOutputPosition (pendingFrame) < outputReadPosition + L)
+            finishPendingFrame();
+
+        readOutput (outputBlock, numChOut, L);
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.framesPerProcessCall.add ((uint64) statistics.numFramesInProcessCall);)
+    }
+
+    int getNumInputChannels() const { return nChIn; }
+    int getNumOutputChannels() const { return nChOut; }
+
+    /**
+     Returns the number of bytes this instance occupies after `prepare()`: the buffers for the input history, the frames
+     and the overlap-add output, the spectra and the bookkeeping of its resolutions. The windows and transforms are shared
+     with all other processors using the same ones (see WindowCache and FFTPlanCache), so they aren't included, neither
+     is the scratch memory of the transforms (one workspace per thread, see FFTBackend::createWorkspace()).
+     Don't call this concurrently with `prepare()` or `setResolution()`.
+     */
+    size_t getMemoryFootprintBytes() const
+    {
+        size_t numBytes = sizeof (*this) + bufferMemorySize;
+        numBytes += spectrumBuffer.getSizeInBytes() + inputSpectra.getSizeInBytes() + outputSpectra.getSizeInBytes();
+        numBytes += currentSpectra.getSizeInBytes();
+
+        for (auto* pastSpectra : spectralHistory)
+            numBytes += sizeof (*pastSpectra) + pastSpectra->getSizeInBytes();
+        numBytes += (size_t) configurations.size() * sizeof (Configuration);
+        numBytes += (size_t) backgroundFrames.size() * (sizeof (BackgroundFrame) + (size_t) nChIn * sizeof (bool));
+        numBytes += (size_t) nChIn * (sizeof (int64) + sizeof (bool)); // activity detection
+        numBytes += (size_t) jmax (nChIn, nChOut) * (sizeof (int) + sizeof (SampleType*)); // batched transforms
+
+        const auto numParameters = (size_t) frameParameters.getNumParameters();
+        numBytes += frameParameters.getSizeInBytes() + (1 + (size_t) backgroundFrames.size()) * numParameters * sizeof (float);
+
+        if (tapMagnitudes != nullptr)
+            numBytes += 2 * (size_t) maximumFftSize * sizeof (SampleType);
+
+        return numBytes;
+    }
+
+    /**
+     Attaches a SpectrumTap, to which the magnitude spectra of the frames are published (before they are processed).
+     Has to be called before `prepare()`, pass nullptr to detach it. The tap has to outlive the processor, or be detached.
+     During a resolution change, only the frames of the new resolution are published.
+     */
+    void setSpectrumTap (SpectrumTap* tapToUse)
+    {
+        spectrumTap = tapToUse;
+    }
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    /** Returns the measurements of the processor, see ProcessorStatistics. Only available with OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS=1. */
+    ProcessorStatistics& getStatistics() { return statistics; }
+    const ProcessorStatistics& getStatistics() const { return statistics; }
+   #endif
+
+    /**
+     Sets the number of additional threads which help processing the channels of each frame in parallel.
+     The channels are then handed to the `processFrame()` callback from the audio thread and those workers.
+     Pass 0 to process all channels on the audio thread (default). Don't call this while `process()` might be running.
+     With background scheduling, the background thread is stopped while the transform workspaces are recreated.
+     After each frame, the workers spin for the next one for `workerSpinTimeInMilliseconds` before they sleep: with
+     frames more often than that (e.g. a hopSize of 64 samples at 48 kHz every 1.3 ms), each worker keeps a core busy.
+     Pass a shorter spin time to save that CPU, at the cost of workers which might have to wake up first.
+     */
+    void setNumWorkerThreads (const int numWorkerThreads, const double workerSpinTimeInMilliseconds = FrameWorkerPool::defaultSpinTimeInMilliseconds)
+    {
+        jassert (numWorkerThreads >= 0);
+
+        // the frame members and workspaces belong to the background thread while it's running
+        const bool wasBackgroundThreadRunning = backgroundThread.isThreadRunning();
+        backgroundThread.stopThread (1000);
+
+        if (numWorkerThreads > 0)
+            workerPool.reset (new FrameWorkerPool (numWorkerThreads, workerSpinTimeInMilliseconds));
+        else
+            workerPool.reset();
+
+        // each thread needs its own transform workspace
+        for (auto* configuration : configurations)
+            createWorkspaces (*configuration);
+
+        fft.transform = activeStream.configuration->fft.get();
+        fft.workspaces = activeStream.configuration->workspaces.get();
+
+        if (wasBackgroundThreadRunning)
+            backgroundThread.startThread (8);
+    }
+
+    int getNumWorkerThreads() const { return workerPool == nullptr ? 0 : workerPool->getNumWorkerThreads(); }
 
-        outputOffset -= L;
+    /**
+     The default window: a periodic Hann window. If the fftSize is a multiple of the hopSize, the overlapping windows sum up
+     to fftSize / hopSize / 2, which is compensated, so an unaltered frame is reconstructed perfectly. The MultiResolutionFFTProcessor uses it as well.
+     */
+    static void createHannWindow (std::vector<SampleType>& windowToFill, const Resolution resolution)
+    {
+        const double hopSizeCompensateFactor = 2.0 * resolution.hopSize / resolution.fftSize;
+        for (int i = 0; i < resolution.fftSize; ++i)
+            windowToFill[(size_t) i] = (SampleType) (hopSizeCompensateFactor * 0.5 * (1.0 - std::cos (2.0 * MathConstants<double>::pi * i / resolution.fftSize)));
     }
 
-    const int getNumInputChannels() const { return nChIn; }
-    const int getNumOutputChannels() const { return nChOut; }
-    
 private:
-    virtual void createWindow()
+    enum class ChannelTask
+    {
+        processFrame,
+        forwardTransform,
+        inverseTransform,
+        batchedForwardTransform,
+        batchedInverseTransform
+    };
+
+    // the processor transforms the channels in batches, if there are at least that many, and the fftSize is at most...
+    static constexpr int minNumChannelsForBatchedTransforms = 2 * BatchedRealFFT<SampleType>::numLanes;
+    static constexpr int maxFftSizeForBatchedTransforms = 2048;
+
+    /**
+     Fills the analysis window for the given resolution, which is used with a rectangular synthesis window.
+     It's called by the default `createWindows()` outside of the low-latency mode. Don't change the size of the window.
+     */
+    virtual void createWindow (std::vector<SampleType>& windowToFill, const Resolution resolution)
     {
-        dsp::WindowingFunction<float>::fillWindowingTables (window.data(), fftSize, dsp::WindowingFunction<float>::WindowingMethod::hann, false);
+        createHannWindow (windowToFill, resolution);
+    }
 
-        const float hopSizeCompensateFactor = 1.0f / (fftSize / hopSize / 2);
-        for (auto& elem : window)
-            elem *= hopSizeCompensateFactor;
+    /**
+     Fills the analysis window, which is applied to the input frames, and the synthesis window, which is applied to
+     the processed frames before they are overlap-added. It's called by `setResolution()` on the calling thread,
+     and by `prepare()`. Don't change the size of the windows. In low-latency mode, the synthesis window has to be
+     zero except for its last `getSynthesisWindowLength()` samples.
+     By default, it uses `createWindow()` and a rectangular synthesis window, or `createLowDelayWindows()` in low-latency mode.
+     */
+    virtual void createWindows (std::vector<SampleType>& analysisWindow, std::vector<SampleType>& synthesisWindow, const Resolution resolution)
+    {
+        if (synthesisWindowLength > 0)
+        {
+            createLowDelayWindows (analysisWindow, synthesisWindow, resolution, synthesisWindowLength);
+        }
+        else
+        {
+            createWindow (analysisWindow, resolution);
+            std::fill (synthesisWindow.begin(), synthesisWindow.end(), (SampleType) 1);
+        }
     }
 
     /**
@@ -250,34 +777,1338 @@ private:
      frequency domain, do your calculations, and transform it back to time domain.
      @param maxNumChannels the max number of channels of `fftInOutBuffer` you should use
      */
-    virtual void processFrameInBuffer (const int maxNumChannels) {}
+    virtual void processFrameInBuffer (const int maxNumChannels)
+    {
+        processChannels (maxNumChannels);
+    }
+
+    /**
+     This method get's called for each channel of a frame, if you don't override `processFrameInBuffer()`.
+     When worker threads are used, it's called concurrently for different channels, so only touch the
+     data of the given channel. The `fft` member can be used from several threads at once.
+     @param channel the channel index
+     @param data the channel's samples in `fftInOutBuffer` (2 * fftSize values)
+     */
+    virtual void processFrame (const int channel, SampleType* data) { ignoreUnused (channel, data); }
+
+    /**
+     This method get's called for each frame in `FrameDomain::frequency`. The `fftInOutBuffer` holds the
+     spectra of the frame, as returned by `fft.performRealOnlyForwardTransform (data, true)`, and will be
+     transformed back to time domain afterwards.
+     @param maxNumChannels the max number of channels of `fftInOutBuffer` you should use
+     */
+    virtual void processSpectrumInBuffer (const int maxNumChannels) { ignoreUnused (maxNumChannels); }
+
+    /**
+     This method get's called for each frame in `FrameDomain::splitComplex`. The `spectrumBuffer` holds the
+     fftSize / 2 + 1 non-negative frequency bins of each channel, as separate real and imaginary arrays.
+     They will be transformed back to time domain afterwards.
+     @param maxNumChannels the max number of channels of `spectrumBuffer` you should use
+     */
+    virtual void processSplitSpectrumInBuffer (const int maxNumChannels) { ignoreUnused (maxNumChannels); }
 
-    void writeBackFrame()
+    /**
+     This method get's called for each frame in `FrameDomain::matrix`. `inputSpectra` holds the fftSize / 2 + 1
+     non-negative frequency bins of the input channels, fill the output channels' spectra in `outputSpectra`, which
+     will be transformed back to time domain afterwards. By default, the input channels are passed through.
+     @param numInputChannels the number of channels of `inputSpectra`
+     @param numOutputChannels the number of channels of `outputSpectra`
+     */
+    virtual void processMatrixSpectra (const int numInputChannels, const int numOutputChannels)
     {
-        for (int ch = 0; ch < nChOut; ++ch)
+        for (int ch = 0; ch < numOutputChannels; ++ch)
         {
-            outputBuffer.addFrom (ch, outputOffset, fftInOutBuffer, ch, 0, fftSize - hopSize);
-            outputBuffer.copyFrom (ch, outputOffset + fftSize - hopSize, fftInOutBuffer, ch, fftSize - hopSize, hopSize);
+            const int numBins = outputSpectra.getNumBins();
+
+            if (ch < numInputChannels)
+            {
+                FloatVectorOperations::copy (outputSpectra.getRealPointer (ch), inputSpectra.getRealPointer (ch), numBins);
+                FloatVectorOperations::copy (outputSpectra.getImagPointer (ch), inputSpectra.getImagPointer (ch), numBins);
+            }
+            else
+            {
+                FloatVectorOperations::clear (outputSpectra.getRealPointer (ch), numBins);
+                FloatVectorOperations::clear (outputSpectra.getImagPointer (ch), numBins);
+            }
         }
-        outputOffset += hopSize;
     }
 
-protected:
-    dsp::FFT fft;
-    std::vector<float> window;
-    AudioBuffer<float> fftInOutBuffer;
-    const int fftSize;
-    const int hopSize;
+    /** Returns the buffer the spectra of the forward transforms are copied to, or nullptr if they stay in `fftInOutBuffer`. */
+    SplitComplexBuffer<SampleType>* getForwardSpectra() noexcept
+    {
+        return domain == FrameDomain::splitComplex ? &spectrumBuffer : (domain == FrameDomain::matrix ? &inputSpectra : nullptr);
+    }
 
-private:
-    int nChIn;
-    int nChOut;
+    /** Returns the buffer the spectra of the inverse transforms are taken from, or nullptr if they are in `fftInOutBuffer`. */
+    SplitComplexBuffer<SampleType>* getInverseSpectra() noexcept
+    {
+        return domain == FrameDomain::splitComplex ? &spectrumBuffer : (domain == FrameDomain::matrix ? &outputSpectra : nullptr);
+    }
+
+    /** Number of channels which are transformed forward, in matrix domain only the input channels. */
+    int getNumForwardTransforms (const int maxNumChannels) const noexcept
+    {
+        return domain == FrameDomain::matrix ? nChIn : maxNumChannels;
+    }
+
+    /** Number of channels which are transformed back, in matrix domain only the output channels. */
+    int getNumInverseTransforms (const int maxNumChannels) const noexcept
+    {
+        return domain == FrameDomain::matrix ? nChOut : maxNumChannels;
+    }
 
-    AudioBuffer<float> notYetUsedAudioData;
-    AudioBuffer<float> outputBuffer;
-    int outputOffset;
+    /** Forward transform of a channel of `fftInOutBuffer`, in split-complex and matrix domain also copied to their spectra. */
+    void forwardTransform (const int channel, SampleType* data)
+    {
+        // the frame of an inactive channel is already zero, and so is its spectrum
+        if (! isChannelActive (channel))
+        {
+            clearSpectrum (getForwardSpectra(), channel);
+            clearSpectrum (getHistoryCopy(), channel);
+            return;
+        }
 
-    int notYetUsedAudioDataCount = 0;
+        fft.performRealOnlyForwardTransform (data, true);
+        copyForwardSpectrum (channel, data);
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.numTransforms.fetch_add (1, std::memory_order_relaxed);)
+    }
 
-    JUCE_DECLARE_NON_COPYABLE (OverlappingFFTProcessor)
-};
+    static void clearSpectrum (SplitComplexBuffer<SampleType>* spectra, const int channel) noexcept
+    {
+        if (spectra != nullptr)
+        {
+            FloatVectorOperations::clear (spectra->getRealPointer (channel), spectra->getNumBins());
+            FloatVectorOperations::clear (spectra->getImagPointer (channel), spectra->getNumBins());
+        }
+    }
+
+    /** Copies a forward transformed channel to the split-complex spectra of the frame domain and the spectral history. */
+    void copyForwardSpectrum (const int channel, const SampleType* data)
+    {
+        if (auto* spectra = getForwardSpectra())
+            spectra->copyFromInterleaved (channel, data);
+
+        if (auto* spectra = getHistoryCopy())
+            spectra->copyFromInterleaved (channel, data);
+    }
+
+    /** Inverse transform of a channel of `fftInOutBuffer`, in split-complex and matrix domain its spectrum is taken from their spectra. */
+    void inverseTransform (const int channel, SampleType* data)
+    {
+        // in matrix domain, the output channels are mixtures of all inputs
+        if (domain != FrameDomain::matrix && ! isChannelActive (channel))
+            return;
+
+        if (auto* spectra = getInverseSpectra())
+            spectra->copyToInterleaved (channel, data);
+
+        fft.performRealOnlyInverseTransform (data);
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.numTransforms.fetch_add (1, std::memory_order_relaxed);)
+    }
+
+    /**
+     Collects the channels which `forwardTransform()` or `inverseTransform()` wouldn't skip into `batchedChannels`,
+     and returns their number.
+     */
+    int gatherBatchedChannels (const int numChannels, const ChannelTask task) noexcept
+    {
+        const bool transformsAllChannels = task == ChannelTask::inverseTransform && domain == FrameDomain::matrix;
+        int numBatchedChannels = 0;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            if (transformsAllChannels || isChannelActive (ch))
+                batchedChannels[numBatchedChannels++] = ch;
+
+        return numBatchedChannels;
+    }
+
+    /** Forward transforms of a batch of the gathered channels (one per SIMD lane), see `forwardTransform()`. */
+    void batchedForwardTransform (const int batch)
+    {
+        const int first = batch * BatchedRealFFT<SampleType>::numLanes;
+        const int numChannelsInBatch = jmin (BatchedRealFFT<SampleType>::numLanes, numBatchedChannels - first);
+        typename TransformWorkspaces::ScopedSlot workspace (*fft.workspaces);
+        batchedFFT->performRealOnlyForwardTransforms (batchedChannelData + first, numChannelsInBatch, workspace->batchedFFT.get());
+
+        for (int i = first; i < first + numChannelsInBatch; ++i)
+            copyForwardSpectrum (batchedChannels[i], batchedChannelData[i]);
+
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.numTransforms.fetch_add ((uint64) numChannelsInBatch, std::memory_order_relaxed);)
+    }
+
+    /** Inverse transforms of a batch of the gathered channels (one per SIMD lane), see `inverseTransform()`. */
+    void batchedInverseTransform (const int batch)
+    {
+        const int first = batch * BatchedRealFFT<SampleType>::numLanes;
+        const int numChannelsInBatch = jmin (BatchedRealFFT<SampleType>::numLanes, numBatchedChannels - first);
+
+        if (auto* spectra = getInverseSpectra())
+            for (int i = first; i < first + numChannelsInBatch; ++i)
+                spectra->copyToInterleaved (batchedChannels[i], batchedChannelData[i]);
+
+        typename TransformWorkspaces::ScopedSlot workspace (*fft.workspaces);
+        batchedFFT->performRealOnlyInverseTransforms (batchedChannelData + first, numChannelsInBatch, workspace->batchedFFT.get());
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (statistics.numTransforms.fetch_add ((uint64) numChannelsInBatch, std::memory_order_relaxed);)
+    }
+
+    /** Calls the spectral callback of the current frame domain, and adds the frame's input spectra to the spectral history. */
+    void processSpectra (const int maxNumChannels)
+    {
+        beginSpectralHistoryFrame();
+
+        if (domain == FrameDomain::matrix)
+            processMatrixSpectra (nChIn, nChOut);
+        else if (domain == FrameDomain::splitComplex)
+            processSplitSpectrumInBuffer (maxNumChannels);
+        else
+            processSpectrumInBuffer (maxNumChannels);
+
+        pushSpectralHistory();
+    }
+
+    /**
+     Returns the buffer the spectral history copies the forward spectra to, or nullptr if there's no history. In matrix
+     domain, the history takes `inputSpectra` as they are, the other domains hand their spectra to the callbacks to be changed.
+     */
+    SplitComplexBuffer<SampleType>* getHistoryCopy() noexcept
+    {
+        return spectralHistory.isEmpty() || domain == FrameDomain::matrix ? nullptr : &currentSpectra;
+    }
+
+    /** Returns the buffer with the current frame's input spectra, which is swapped into the history after the frame. */
+    SplitComplexBuffer<SampleType>& getCurrentSpectra() noexcept
+    {
+        return domain == FrameDomain::matrix ? inputSpectra : currentSpectra;
+    }
+
+    const SplitComplexBuffer<SampleType>& getCurrentSpectra() const noexcept
+    {
+        return domain == FrameDomain::matrix ? inputSpectra : currentSpectra;
+    }
+
+    void prepareSpectralHistory (const int numChannels)
+    {
+        spectralHistory.clear();
+        for (int i = 0; i < spectralHistoryLength; ++i)
+            spectralHistory.add (new SplitComplexBuffer<SampleType> (numChannels, maximumFftSize / 2 + 1));
+
+        currentSpectra.setSize (spectralHistoryLength > 0 && domain != FrameDomain::matrix ? numChannels : 0, maximumFftSize / 2 + 1);
+
+        newestPastSpectra = 0;
+        numPastSpectra = 0;
+        historySerialNumber = -1;
+        isHistoryFrame = false;
+    }
+
+    /**
+     Checks if the current frame continues the history. The frames of a new resolution start a new history, and
+     during the crossfade, the frames of the old resolution don't have any.
+     */
+    void beginSpectralHistoryFrame() noexcept
+    {
+        if (spectralHistory.isEmpty())
+            return;
+
+        if (frameSerialNumber > historySerialNumber)
+        {
+            historySerialNumber = frameSerialNumber;
+            numPastSpectra = 0;
+
+            for (auto* pastSpectra : spectralHistory)
+                pastSpectra->setNumBins (fftSize / 2 + 1);
+        }
+
+        isHistoryFrame = frameSerialNumber == historySerialNumber;
+    }
+
+    /** Swaps the current frame's spectra into the history, in exchange for the oldest ones. */
+    void pushSpectralHistory() noexcept
+    {
+        if (! isHistoryFrame)
+            return;
+
+        newestPastSpectra = (newestPastSpectra + 1) % spectralHistory.size();
+        getCurrentSpectra().swapWith (*spectralHistory.getUnchecked (newestPastSpectra));
+        numPastSpectra = jmin (numPastSpectra + 1, spectralHistory.size());
+        isHistoryFrame = false;
+    }
+
+    /** The scratch memory of one thread for the transforms of a configuration, see FFTBackend::createWorkspace(). */
+    struct TransformWorkspace
+    {
+        std::unique_ptr<FFTWorkspace> fft, batchedFFT;
+    };
+
+    using TransformWorkspaces = ConcurrentSlots<TransformWorkspace>;
+
+    /** Everything which depends on the resolution. */
+    struct Configuration
+    {
+        Configuration (const Resolution r, const int64 serial, std::shared_ptr<const FFTBackend<SampleType>> plan)
+        : resolution (r), serialNumber (serial), fft (std::move (plan)) {}
+
+        const Resolution resolution;
+        const int64 serialNumber;
+        const std::shared_ptr<const FFTBackend<SampleType>> fft;
+        std::shared_ptr<const BatchedRealFFT<SampleType>> batchedFFT;
+
+        // one workspace for each thread which might transform at the same time, see createWorkspaces()
+        std::unique_ptr<TransformWorkspaces> workspaces;
+
+        // the windows are shared with all processors using the same ones, see WindowCache
+        std::shared_ptr<const std::vector<SampleType>> window;
+        std::shared_ptr<const std::vector<SampleType>> synthesisWindow; // nullptr if the synthesis window is rectangular
+        SampleType windowSum = 1;
+        int firstOutputSample = 0; // the synthesis window is zero before this sample
+
+        // only used by the audio thread, which sets isRetired as soon as nothing refers to the configuration anymore
+        int numFramesInFlight = 0;
+        bool hasEnded = false;
+        std::atomic<bool> isRetired { false };
+    };
+
+    /** A linear fade of the output of a stream, in output samples. A length of 0 means no fade. */
+    struct Fade
+    {
+        int64 start = 0;
+        int length = 0;
+        bool isFadeIn = false;
+
+        SampleType getGain (const int64 position) const noexcept
+        {
+            const SampleType progress = (SampleType) jlimit ((int64) 0, (int64) length, position - start) / length;
+            return isFadeIn ? progress : 1 - progress;
+        }
+    };
+
+    /** A sequence of frames with the same configuration. During a resolution change, two streams are crossfaded. */
+    struct Stream
+    {
+        Configuration* configuration = nullptr;
+        int samplesUntilNextFrame = 0;
+        int64 endPosition = std::numeric_limits<int64>::max(); // input position from which on no frames are started
+        Fade fade;
+    };
+
+    /** Everything needed to write back a frame after its processing. */
+    struct FrameInfo
+    {
+        Configuration* configuration = nullptr;
+        Fade fade;
+        int64 outputPosition = 0;
+        int numChannels = 0;
+        const bool* activeChannels = nullptr; // the activity of the input channels, nullptr if all are active
+        const float* parameters = nullptr; // the snapshot of the frame parameters, nullptr without parameters
+    };
+
+    Configuration* createConfiguration (const Resolution resolution)
+    {
+        auto* configuration = configurations.add (new Configuration (resolution, numConfigurationsCreated++, planCache->getPlan (resolution.fftSize)));
+        fillWindows (*configuration);
+
+        // the batched transforms only stand in for the default backend, not for FFTW or one set with FFTPlanCache::setFactory()
+        if (isPowerOfTwo (resolution.fftSize) && resolution.fftSize >= 4 && resolution.fftSize <= maxFftSizeForBatchedTransforms
+             && FFTPlanCache<SampleType>::isDefaultPowerOfTwoBackend (*configuration->fft))
+            configuration->batchedFFT = batchedFFTCache->getTransform (resolution.fftSize);
+
+        createWorkspaces (*configuration);
+        return configuration;
+    }
+
+    /**
+     Creates the transform workspaces of a configuration, all of them up front: one for each worker thread, one for the
+     thread processing the frames (the audio or the background thread), and one for another thread (e.g. one preparing
+     an impulse response). That's the most threads transforming at the same time, so the transforms of the processor
+     never allocate or wait, and don't compete with other processors for the scratch memory of the shared plans.
+     */
+    void createWorkspaces (Configuration& configuration)
+    {
+        const Configuration* owner = &configuration;
+        configuration.workspaces.reset (new TransformWorkspaces ([owner]
+        {
+            auto* workspace = new TransformWorkspace();
+            workspace->fft = owner->fft->createWorkspace();
+
+            if (owner->batchedFFT != nullptr)
+                workspace->batchedFFT = owner->batchedFFT->createWorkspace();
+
+            return workspace;
+        }, getNumWorkerThreads() + 2));
+    }
+
+    /** Creates the windows of a configuration with `createWindows()`, and checks where its synthesis window starts. */
+    void fillWindows (Configuration& configuration)
+    {
+        const int size = configuration.resolution.fftSize;
+        std::vector<SampleType> analysisWindow ((size_t) size), synthesisWindow ((size_t) size);
+        createWindows (analysisWindow, synthesisWindow, configuration.resolution);
+
+        // don`t change the size of the windows during createWindows()!
+        jassert (analysisWindow.size() == (size_t) size && synthesisWindow.size() == (size_t) size);
+
+        bool hasSynthesisWindow = false;
+        for (auto w : synthesisWindow)
+            hasSynthesisWindow |= (w != 1);
+
+        configuration.firstOutputSample = synthesisWindowLength > 0 ? jmax (0, size - synthesisWindowLength) : 0;
+
+        // the latency only covers the last synthesisWindowLength samples of a frame, the synthesis window has to be zero before
+        for (int i = 0; i < configuration.firstOutputSample; ++i)
+            jassert (synthesisWindow[(size_t) i] == 0);
+
+        configuration.windowSum = 0;
+        for (auto w : analysisWindow)
+            configuration.windowSum += w;
+
+        // a rectangular synthesis window isn't stored at all
+        configuration.window = windowCache->getWindow (std::move (analysisWindow));
+        configuration.synthesisWindow = hasSynthesisWindow ? windowCache->getWindow (std::move (synthesisWindow)) : nullptr;
+    }
+
+    void deleteRetiredConfigurations()
+    {
+        for (int i = configurations.size(); --i >= 0;)
+            if (configurations.getUnchecked (i)->isRetired.load())
+                configurations.remove (i);
+    }
+
+    /**
+     Points `fftSize`, `hopSize`, `window` and `fft` to the configuration of the frame which is processed next. Only called
+     by the thread processing the frames: the audio thread, or, with background scheduling, the background thread, which
+     gets the configuration with each frame. Everything else reads the resolution from the configurations.
+     */
+    void setFrameMembers (const Configuration& configuration)
+    {
+        fftSize = configuration.resolution.fftSize;
+        hopSize = configuration.resolution.hopSize;
+        fft.transform = configuration.fft.get();
+        fft.workspaces = configuration.workspaces.get();
+        batchedFFT = configuration.batchedFFT.get();
+        window.values = configuration.window.get();
+        windowSum = configuration.windowSum;
+        frameSerialNumber = configuration.serialNumber;
+
+        if (domain == FrameDomain::splitComplex)
+            spectrumBuffer.setNumBins (fftSize / 2 + 1);
+
+        if (domain == FrameDomain::matrix)
+        {
+            inputSpectra.setNumBins (fftSize / 2 + 1);
+            outputSpectra.setNumBins (fftSize / 2 + 1);
+        }
+
+        if (currentSpectra.getNumChannels() > 0)
+            currentSpectra.setNumBins (fftSize / 2 + 1);
+    }
+
+    /**
+     Starts the crossfade to a resolution set by `setResolution()`, if there is one. Called at a frame boundary of the active stream.
+     The old stream keeps on producing frames until the end of the fade, which starts once the new stream overlaps
+     to full gain, and the last frame of the old stream without fade has ended.
+     */
+    void switchToPendingConfiguration()
+    {
+        auto* nextConfiguration = pendingConfiguration.exchange (nullptr);
+        if (nextConfiguration == nullptr)
+            return;
+
+        const auto& oldResolution = activeStream.configuration->resolution;
+        const auto& newResolution = nextConfiguration->resolution;
+
+        const int64 fadeStart = inputPosition - jmin (oldResolution.hopSize, newResolution.hopSize);
+        const int fadeLength = jmax (1, jmin (oldResolution.fftSize, newResolution.fftSize) / 2);
+        const int64 outputFadeStart = fadeStart + getFrameLatencyInSamples();
+
+        fadingStream = activeStream;
+        fadingStream.endPosition = fadeStart + fadeLength;
+        fadingStream.fade = { outputFadeStart, fadeLength, false };
+
+        activeStream.configuration = nextConfiguration;
+        activeStream.samplesUntilNextFrame = 0;
+        activeStream.fade = { outputFadeStart, fadeLength, true };
+    }
+
+    /** Processes the stream's frame ending at the current input position, or ends the stream if it's over. */
+    void advanceStream (Stream& stream, const int numChIn, const int maxNumChannels)
+    {
+        auto& configuration = *stream.configuration;
+        const int64 frameStart = inputPosition - configuration.resolution.fftSize;
+
+        if (frameStart >= stream.endPosition)
+        {
+            configuration.hasEnded = true;
+            if (configuration.numFramesInFlight == 0)
+                configuration.isRetired = true;
+
+            stream = Stream();
+            return;
+        }
+
+        FrameInfo frame;
+        frame.configuration = &configuration;
+        frame.fade = stream.fade;
+        frame.outputPosition = frameStart + getFrameLatencyInSamples();
+        frame.numChannels = maxNumChannels;
+        ++configuration.numFramesInFlight;
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (++statistics.numFramesInProcessCall;)
+
+        if (scheduling == FrameScheduling::background)
+        {
+            submitFrameToBackgroundThread (frame, numChIn);
+        }
+        else if (scheduling == FrameScheduling::amortized)
+        {
+            finishPendingFrame();
+            frame.activeChannels = detectActiveChannels (frameActivity);
+            frame.parameters = takeParameterSnapshot (frameParameterSnapshot, configuration);
+            windowFrame (fftInOutBuffer, numChIn, configuration, frame.activeChannels);
+            startPendingFrame (frame);
+        }
+        else
+        {
+            frame.activeChannels = detectActiveChannels (frameActivity);
+            frame.parameters = takeParameterSnapshot (frameParameterSnapshot, configuration);
+            windowFrame (fftInOutBuffer, numChIn, configuration, frame.activeChannels);
+
+            // process frame and buffer output
+            setFrameMembers (configuration);
+            processCurrentFrame (frame);
+            writeBackFrame (fftInOutBuffer, frame);
+        }
+
+        stream.samplesUntilNextFrame = configuration.resolution.hopSize;
+    }
+
+    /** Processes the frame in `fftInOutBuffer` with the callback of the current frame domain. */
+    void processCurrentFrame (const FrameInfo& frame)
+    {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (frameProcessing);
+        const int maxNumChannels = frame.numChannels;
+        frameActiveChannels = frame.activeChannels;
+        frameParameterValues = frame.parameters;
+
+        if (domain == FrameDomain::time)
+        {
+            publishSpectrum (frame);
+            processFrameInBuffer (maxNumChannels);
+        }
+        else
+        {
+            processChannels (getNumForwardTransforms (maxNumChannels), ChannelTask::forwardTransform);
+            publishSpectrum (frame);
+            processSpectra (maxNumChannels);
+            processChannels (getNumInverseTransforms (maxNumChannels), ChannelTask::inverseTransform);
+        }
+    }
+
+    /**
+     Publishes the magnitudes of the tapped channel of the frame in `fftInOutBuffer` to the SpectrumTap, if there is one.
+     In time domain, the frame is transformed for it, otherwise the spectra of the forward transforms are used.
+     */
+    void publishSpectrum (const FrameInfo& frame)
+    {
+        // frames which fade out belong to the old resolution of a crossfade
+        if (spectrumTap == nullptr || spectrumTap->getChannel() >= getNumForwardTransforms (frame.numChannels) || (frame.fade.length > 0 && ! frame.fade.isFadeIn))
+            return;
+
+        const int channel = spectrumTap->getChannel();
+        const int numBins = fftSize / 2 + 1;
+        SampleType* magnitudes = tapMagnitudes.get();
+
+        if (domain == FrameDomain::time)
+        {
+            FloatVectorOperations::copy (magnitudes, fftInOutBuffer.getReadPointer (channel), fftSize);
+            FloatVectorOperations::clear (magnitudes + fftSize, fftSize);
+            fft.performFrequencyOnlyForwardTransform (magnitudes);
+        }
+        else if (domain == FrameDomain::frequency)
+        {
+            const SampleType* spectrum = fftInOutBuffer.getReadPointer (channel);
+            for (int k = 0; k < numBins; ++k)
+                magnitudes[k] = std::sqrt (spectrum[2 * k] * spectrum[2 * k] + spectrum[2 * k + 1] * spectrum[2 * k + 1]);
+        }
+        else
+        {
+            getForwardSpectra()->getMagnitudes (channel, magnitudes);
+        }
+
+        // a sine wave with amplitude 1 has a magnitude of windowSum / 2
+        spectrumTap->publish (magnitudes, fftSize, frame.outputPosition - getFrameLatencyInSamples(), 2 / windowSum);
+    }
+
+    /** Calls `processFrame()` (or transforms) for the channels of the frame, in parallel if there are worker threads, and waits until all are done. */
+    void processChannels (const int numChannels, const ChannelTask task = ChannelTask::processFrame)
+    {
+        channelJob.task = task;
+        channelJob.channelData = fftInOutBuffer.getArrayOfWritePointers();
+        int numTasks = numChannels;
+
+        // many channels of small transforms: transform them in batches, one channel per SIMD lane. The batches only
+        // consist of the channels which aren't skipped, the spectra of the inactive ones are cleared right away.
+        if (task != ChannelTask::processFrame && batchedFFT != nullptr && numChannels >= minNumChannelsForBatchedTransforms)
+        {
+            numBatchedChannels = gatherBatchedChannels (numChannels, task);
+
+            if (numBatchedChannels >= minNumChannelsForBatchedTransforms)
+            {
+                for (int i = 0, ch = 0; ch < numChannels; ++ch)
+                {
+                    if (i < numBatchedChannels && batchedChannels[i] == ch)
+                        batchedChannelData[i++] = channelJob.channelData[ch];
+                    else if (task == ChannelTask::forwardTransform)
+                        forwardTransform (ch, channelJob.channelData[ch]);
+                }
+
+                channelJob.task = task == ChannelTask::forwardTransform ? ChannelTask::batchedForwardTransform : ChannelTask::batchedInverseTransform;
+                numTasks = (numBatchedChannels + BatchedRealFFT<SampleType>::numLanes - 1) / BatchedRealFFT<SampleType>::numLanes;
+            }
+        }
+
+        if (workerPool == nullptr || numTasks < 2)
+        {
+            for (int i = 0; i < numTasks; ++i)
+                channelJob.runTask (i);
+
+            return;
+        }
+
+        const int numThreads = workerPool->getNumWorkerThreads() + 1;
+        const int tasksPerGroup = jmax (1, numTasks / (2 * numThreads));
+        workerPool->perform (channelJob, numTasks, tasksPerGroup);
+    }
+
+    /**
+     Copies the last fftSize samples of the input history into the given buffer (with windowing). The frames of inactive
+     channels are cleared instead, including the two values of the spectrum beyond the fftSize.
+     */
+    void windowFrame (AudioBuffer<SampleType>& frameBuffer, const int numChannels, const Configuration& configuration, const bool* activeChannels)
+    {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (windowing);
+
+        const int frameSize = configuration.resolution.fftSize;
+        const SampleType* frameWindow = configuration.window->data();
+
+        const int frameStart = (int) ((inputPosition - frameSize) & inputBufferMask);
+        const int firstPart = jmin (frameSize, inputBuffer.getNumSamples() - frameStart);
+        const int secondPart = frameSize - firstPart;
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            if (activeChannels != nullptr && ! activeChannels[ch])
+            {
+                FloatVectorOperations::clear (frameBuffer.getWritePointer (ch), frameSize + 2);
+                continue;
+            }
+
+            FloatVectorOperations::multiply (frameBuffer.getWritePointer (ch),
+                                             inputBuffer.getReadPointer (ch, frameStart),
+                                             frameWindow, firstPart);
+            FloatVectorOperations::multiply (frameBuffer.getWritePointer (ch, firstPart),
+                                             inputBuffer.getReadPointer (ch),
+                                             frameWindow + firstPart, secondPart);
+        }
+
+        // channels without input (e.g. more outputs than inputs) start silent, not with the last frame's data
+        for (int ch = numChannels; ch < frameBuffer.getNumChannels(); ++ch)
+            FloatVectorOperations::clear (frameBuffer.getWritePointer (ch), frameSize);
+    }
+
+    /**
+     Windows the frame starting at `startSample` of `input` into `fftInOutBuffer` and processes it with the callback of
+     the current frame domain, the result (with the synthesis window applied) stays in `fftInOutBuffer`. Used by the
+     OfflineRenderer instead of `process()`.
+     @param position input sample position of the frame, which is reported to the SpectrumTap
+     */
+    void processOfflineFrame (const AudioBuffer<SampleType>& input, const int startSample, const int64 position)
+    {
+        auto& configuration = *activeStream.configuration;
+        const int frameSize = configuration.resolution.fftSize;
+        const int numChIn = jmin (input.getNumChannels(), nChIn);
+
+        {
+            OVERLAPPINGFFTPROCESSOR_MEASURE (windowing);
+
+            for (int ch = 0; ch < numChIn; ++ch)
+                FloatVectorOperations::multiply (fftInOutBuffer.getWritePointer (ch), input.getReadPointer (ch, startSample),
+                                                 configuration.window->data(), frameSize);
+
+            for (int ch = numChIn; ch < fftInOutBuffer.getNumChannels(); ++ch)
+                FloatVectorOperations::clear (fftInOutBuffer.getWritePointer (ch), frameSize);
+        }
+
+        FrameInfo frame;
+        frame.configuration = &configuration;
+        frame.outputPosition = position + getFrameLatencyInSamples();
+        frame.numChannels = jmax (numChIn, nChOut);
+
+        setFrameMembers (configuration);
+        processCurrentFrame (frame);
+        applySynthesisWindow (fftInOutBuffer, configuration);
+    }
+
+    /**
+     Allocates the input history, the frame buffer, the output buffer and the buffers of the background frames in a single
+     (cleared) block, so an instance's audio data is contiguous. Each channel starts at a cache line, and only the frame
+     buffer holds 2 * fftSize values per channel, which the transforms need. Background frames only hold the samples.
+     */
+    void allocateBuffers (const int inputBufferSize, const int outputBufferSize)
+    {
+        struct Layout
+        {
+            AudioBuffer<SampleType>* buffer;
+            int numChannels;
+            int numSamples;
+        };
+
+        const int maxCh = jmax (nChIn, nChOut);
+        std::vector<Layout> layouts { { &inputBuffer, nChIn, inputBufferSize },
+                                      { &fftInOutBuffer, maxCh, 2 * maximumFftSize },
+                                      { &outputBuffer, nChOut, outputBufferSize } };
+
+        // the two values beyond the fftSize are cleared for inactive channels, see windowFrame()
+        for (auto* frame : backgroundFrames)
+            layouts.push_back ({ &frame->buffer, maxCh, maximumFftSize + 2 });
+
+        constexpr int valuesPerAlignment = bufferAlignmentInBytes / (int) sizeof (SampleType);
+        const auto getStride = [] (const int numSamples) { return (numSamples + valuesPerAlignment - 1) / valuesPerAlignment * valuesPerAlignment; };
+
+        size_t numValues = 0;
+        int numChannels = 0;
+        for (auto& layout : layouts)
+        {
+            numValues += (size_t) layout.numChannels * (size_t) getStride (layout.numSamples);
+            numChannels += layout.numChannels;
+        }
+
+        bufferMemory.calloc (numValues + valuesPerAlignment);
+        bufferMemorySize = (numValues + valuesPerAlignment) * sizeof (SampleType);
+        const auto offset = (bufferAlignmentInBytes - ((pointer_sized_int) bufferMemory.get() & (bufferAlignmentInBytes - 1))) & (bufferAlignmentInBytes - 1);
+        SampleType* data = bufferMemory.get() + offset / sizeof (SampleType);
+
+        // the buffers copy the channel pointers
+        HeapBlock<SampleType*> channels ((size_t) numChannels + 1);
+        SampleType** layoutChannels = channels.get();
+
+        for (auto& layout : layouts)
+        {
+            for (int ch = 0; ch < layout.numChannels; ++ch)
+            {
+                layoutChannels[ch] = data;
+                data += getStride (layout.numSamples);
+            }
+
+            layout.buffer->setDataToReferTo (layoutChannels, layout.numChannels, layout.numSamples);
+            layoutChannels += layout.numChannels;
+        }
+    }
+
+    /** Returns the processed samples from outputBuffer and clears them for the upcoming frames. */
+    void readOutput (dsp::AudioBlock<SampleType>& outputBlock, const int numChOut, const int L)
+    {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (outputRead);
+
+        const int readIndex = (int) (outputReadPosition & outputBufferMask);
+        const int firstPart = jmin (L, outputBuffer.getNumSamples() - readIndex);
+        const int secondPart = L - firstPart;
+
+        for (int ch = 0; ch < numChOut; ++ch)
+        {
+            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch), outputBuffer.getReadPointer (ch, readIndex), firstPart);
+            FloatVectorOperations::copy (outputBlock.getChannelPointer (ch) + firstPart, outputBuffer.getReadPointer (ch), secondPart);
+        }
+
+        for (int ch = 0; ch < nChOut; ++ch)
+        {
+            FloatVectorOperations::clear (outputBuffer.getWritePointer (ch, readIndex), firstPart);
+            FloatVectorOperations::clear (outputBuffer.getWritePointer (ch), secondPart);
+        }
+
+        for (int ch = numChOut; ch < (int) outputBlock.getNumChannels(); ++ch)
+            FloatVectorOperations::clear (outputBlock.getChannelPointer (ch), L);
+
+        outputReadPosition += L;
+    }
+
+    /** Multiplies the output channels of a processed frame with the synthesis window of its configuration, if it has one. */
+    void applySynthesisWindow (AudioBuffer<SampleType>& frameBuffer, const Configuration& configuration)
+    {
+        if (configuration.synthesisWindow == nullptr)
+            return;
+
+        for (int ch = 0; ch < nChOut; ++ch)
+            FloatVectorOperations::multiply (frameBuffer.getWritePointer (ch), configuration.synthesisWindow->data(), configuration.resolution.fftSize);
+    }
+
+    /**
+     Adds a processed frame to the output buffer (applying the synthesis window and its fade) and releases its configuration.
+     Only the samples from the configuration's first output sample on are added, the synthesis window is zero before.
+     */
+    void writeBackFrame (AudioBuffer<SampleType>& frameBuffer, const FrameInfo& frame)
+    {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (writeBack);
+
+        applySynthesisWindow (frameBuffer, *frame.configuration);
+
+        const int firstSample = frame.configuration->firstOutputSample;
+        const int numSamples = frame.configuration->resolution.fftSize - firstSample;
+        const int64 position = frame.outputPosition + firstSample;
+        const auto& fade = frame.fade;
+        const int writeIndex = (int) (position & outputBufferMask);
+
+        if (fade.length == 0 || position >= fade.start + fade.length || position + numSamples <= fade.start)
+        {
+            // no fade within the frame, the gain is either 0 or 1
+            if (fade.length == 0 || fade.getGain (position) > 0.5f)
+            {
+                const int firstPart = jmin (numSamples, outputBuffer.getNumSamples() - writeIndex);
+                const int secondPart = numSamples - firstPart;
+
+                for (int ch = 0; ch < nChOut; ++ch)
+                {
+                    if (! isOutputActive (frame, ch))
+                        continue;
+
+                    FloatVectorOperations::add (outputBuffer.getWritePointer (ch, writeIndex), frameBuffer.getReadPointer (ch, firstSample), firstPart);
+                    FloatVectorOperations::add (outputBuffer.getWritePointer (ch), frameBuffer.getReadPointer (ch, firstSample + firstPart), secondPart);
+                }
+            }
+        }
+        else
+        {
+            for (int ch = 0; ch < nChOut; ++ch)
+            {
+                if (! isOutputActive (frame, ch))
+                    continue;
+
+                SampleType* out = outputBuffer.getWritePointer (ch);
+                const SampleType* in = frameBuffer.getReadPointer (ch, firstSample);
+
+                for (int i = 0; i < numSamples; ++i)
+                    out[(writeIndex + i) & outputBufferMask] += fade.getGain (position + i) * in[i];
+            }
+        }
+
+        auto& configuration = *frame.configuration;
+        if (--configuration.numFramesInFlight == 0 && configuration.hasEnded)
+            configuration.isRetired = true;
+    }
+
+    /** Checks if a frame's output channel has to be added to the output, i.e. its input channel wasn't silent. */
+    bool isOutputActive (const FrameInfo& frame, const int channel) const noexcept
+    {
+        return frame.activeChannels == nullptr || channel >= nChIn || domain == FrameDomain::matrix || frame.activeChannels[channel];
+    }
+
+    /** Measures the level of the input channels' new samples, and remembers up to where they were active. */
+    void measureActivity (const dsp::AudioBlock<const SampleType>& inputBlock, const int startSample, const int numSamples, const int numChIn)
+    {
+        if (numSamples == 0)
+            return;
+
+        for (int ch = 0; ch < numChIn; ++ch)
+        {
+            const SampleType* samples = inputBlock.getChannelPointer (ch) + startSample;
+            SampleType level = 0;
+
+            if (activityDetection == ActivityDetection::peak)
+            {
+                SampleType minimum, maximum;
+                FloatVectorOperations::findMinAndMax (samples, numSamples, minimum, maximum);
+                level = jmax (-minimum, maximum);
+            }
+            else
+            {
+                for (int i = 0; i < numSamples; ++i)
+                    level += samples[i] * samples[i];
+
+                level = std::sqrt (level / numSamples);
+            }
+
+            if (level > activityThreshold)
+                lastActivePositions[ch] = inputPosition;
+        }
+    }
+
+    /** Fills the activity of the input channels for a frame ending at the current input position, returns nullptr without activity detection. */
+    const bool* detectActiveChannels (bool* activeChannels) const noexcept
+    {
+        if (activityDetection == ActivityDetection::off)
+            return nullptr;
+
+        for (int ch = 0; ch < nChIn; ++ch)
+            activeChannels[ch] = lastActivePositions[ch] > inputPosition - activityHoldLength;
+
+        return activeChannels;
+    }
+
+    /**
+     Fills the frame parameters at the centre of a frame ending at the current input position, using the changes up to
+     its last sample. Returns nullptr without parameters.
+     */
+    const float* takeParameterSnapshot (float* destination, const Configuration& configuration) const noexcept
+    {
+        const int frameSize = configuration.resolution.fftSize;
+        const double centre = (double) (inputPosition - frameSize) + 0.5 * (frameSize - 1);
+        return frameParameters.getSnapshot (destination, centre, inputPosition);
+    }
+
+    /** Returns the output position of the first sample a frame adds to the output buffer. */
+    static int64 getFirstOutputPosition (const FrameInfo& frame) noexcept
+    {
+        return frame.outputPosition + frame.configuration->firstOutputSample;
+    }
+
+    /** The latency of the frames' output, the output positions of the frames are based on it. */
+    int getFrameLatencyInSamples() const
+    {
+        return (synthesisWindowLength > 0 ? synthesisWindowLength : maximumFftSize) - 1 + getNumDeferredSamples();
+    }
+
+    /** Number of samples the output of a frame is deferred, in order to have one hop for processing it. */
+    int getNumDeferredSamples() const
+    {
+        return scheduling == FrameScheduling::synchronous ? 0 : deferredHopSize;
+    }
+
+    /** Starts the amortized processing of the frame in `fftInOutBuffer`: forward transforms, spectral callback, inverse transforms. */
+    void startPendingFrame (const FrameInfo& frame)
+    {
+        setFrameMembers (*frame.configuration);
+        frameActiveChannels = frame.activeChannels;
+        frameParameterValues = frame.parameters;
+        pendingFrame = frame;
+        numPendingFrameForwardTransforms = getNumForwardTransforms (frame.numChannels);
+        numPendingFrameTasks = numPendingFrameForwardTransforms + 1 + getNumInverseTransforms (frame.numChannels);
+        nextPendingFrameTask = 0;
+        pendingFrameTaskBudget = 0.0;
+    }
+
+    /** Runs the share of the pending frame's tasks corresponding to the given number of new input samples. */
+    void runPendingFrameTasks (const int numSamples)
+    {
+        if (numPendingFrameTasks == 0)
+            return;
+
+        pendingFrameTaskBudget += (double) numSamples * numPendingFrameTasks / pendingFrame.configuration->resolution.hopSize;
+
+        while (pendingFrameTaskBudget >= 1.0 && nextPendingFrameTask < numPendingFrameTasks)
+        {
+            runPendingFrameTask (nextPendingFrameTask++);
+            pendingFrameTaskBudget -= 1.0;
+        }
+    }
+
+    /** Runs all remaining tasks of the pending frame and writes it back. */
+    void finishPendingFrame()
+    {
+        if (numPendingFrameTasks == 0)
+            return;
+
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (if (nextPendingFrameTask < numPendingFrameTasks) statistics.numForcedFrameCompletions.fetch_add (1, std::memory_order_relaxed);)
+
+        while (nextPendingFrameTask < numPendingFrameTasks)
+            runPendingFrameTask (nextPendingFrameTask++);
+
+        writeBackFrame (fftInOutBuffer, pendingFrame);
+        numPendingFrameTasks = 0;
+    }
+
+    void runPendingFrameTask (const int task)
+    {
+        OVERLAPPINGFFTPROCESSOR_MEASURE (frameProcessing);
+        const int numForwardTransforms = numPendingFrameForwardTransforms;
+
+        if (task < numForwardTransforms)
+            forwardTransform (task, fftInOutBuffer.getWritePointer (task));
+        else if (task == numForwardTransforms)
+        {
+            publishSpectrum (pendingFrame);
+            processSpectra (pendingFrame.numChannels);
+        }
+        else
+            inverseTransform (task - numForwardTransforms - 1, fftInOutBuffer.getWritePointer (task - numForwardTransforms - 1));
+    }
+
+    void submitFrameToBackgroundThread (const FrameInfo& frameInfo, const int numChIn)
+    {
+        // make room in case all frames are still in use (the background thread is way too late)
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (if (numFramesSubmitted.load() - numFramesWrittenBack >= backgroundFrames.size()) statistics.numStalledSubmissions.fetch_add (1, std::memory_order_relaxed);)
+        while (numFramesSubmitted.load() - numFramesWrittenBack >= backgroundFrames.size())
+            writeBackBackgroundFrames (frameInfo.outputPosition + 1);
+
+        auto& frame = *backgroundFrames.getUnchecked ((int) (numFramesSubmitted.load() % backgroundFrames.size()));
+        frame.info = frameInfo;
+        frame.info.activeChannels = detectActiveChannels (frame.activeChannels);
+        frame.info.parameters = takeParameterSnapshot (frame.parameters, *frameInfo.configuration);
+        windowFrame (frame.buffer, numChIn, *frameInfo.configuration, frame.info.activeChannels);
+
+        ++numFramesSubmitted;
+    }
+
+    /**
+     Writes back all frames the background thread has finished. Frames which are needed for output
+     samples before `position` are waited for.
+     */
+    void writeBackBackgroundFrames (const int64 position)
+    {
+        OVERLAPPINGFFTPROCESSOR_STATISTICS (bool hasWaited = false;)
+
+        while (numFramesWrittenBack < numFramesSubmitted.load())
+        {
+            auto& frame = *backgroundFrames.getUnchecked ((int) (numFramesWrittenBack % backgroundFrames.size()));
+
+            if (numFramesWrittenBack < numFramesProcessed.load())
+            {
+                writeBackFrame (frame.buffer, frame.info);
+                ++numFramesWrittenBack;
+            }
+            else if (isAnyFrameNeededBefore (position))
+            {
+                OVERLAPPINGFFTPROCESSOR_STATISTICS (if (! hasWaited) statistics.numLateFrames.fetch_add (1, std::memory_order_relaxed);)
+                OVERLAPPINGFFTPROCESSOR_STATISTICS (hasWaited = true;)
+                Thread::yield(); // the background thread is late, we have to wait
+            }
+            else
+                break;
+        }
+    }
+
+    /** Checks the frames which haven't been written back yet. During a crossfade, their output positions are not in order. */
+    bool isAnyFrameNeededBefore (const int64 position) const
+    {
+        for (auto i = numFramesWrittenBack; i < numFramesSubmitted.load(); ++i)
+            if (getFirstOutputPosition (backgroundFrames.getUnchecked ((int) (i % backgroundFrames.size()))->info) < position)
+                return true;
+
+        return false;
+    }
+
+    /** Processes the submitted frames one after another. */
+    void processBackgroundFrames()
+    {
+        while (numFramesProcessed.load() < numFramesSubmitted.load())
+        {
+            auto& frame = *backgroundFrames.getUnchecked ((int) (numFramesProcessed.load() % backgroundFrames.size()));
+            const int frameSize = frame.info.configuration->resolution.fftSize;
+
+            for (int ch = 0; ch < frame.info.numChannels; ++ch)
+                fftInOutBuffer.copyFrom (ch, 0, frame.buffer, ch, 0, frameSize);
+
+            setFrameMembers (*frame.info.configuration);
+            processCurrentFrame (frame.info);
+
+            for (int ch = 0; ch < nChOut; ++ch)
+                frame.buffer.copyFrom (ch, 0, fftInOutBuffer, ch, 0, frameSize);
+
+            ++numFramesProcessed;
+        }
+    }
+
+    class BackgroundThread : public Thread
+    {
+    public:
+        BackgroundThread (BasicOverlappingFFTProcessor& p) : Thread ("OverlappingFFTProcessor Background Thread"), processor (p) {}
+        ~BackgroundThread() { stopThread (1000); }
+
+        void run() override
+        {
+            auto lastActivity = Time::getMillisecondCounterHiRes();
+
+            while (! threadShouldExit())
+            {
+                if (processor.numFramesProcessed.load() < processor.numFramesSubmitted.load())
+                {
+                    processor.processBackgroundFrames();
+                    lastActivity = Time::getMillisecondCounterHiRes();
+                }
+                else if (Time::getMillisecondCounterHiRes() - lastActivity < 200.0)
+                    Thread::yield();
+                else
+                    wait (1);
+            }
+        }
+
+    private:
+        BasicOverlappingFFTProcessor& processor;
+    };
+
+protected:
+    /** Gives access to the transforms of the current frame's fftSize, with the same interface as juce::dsp::FFT. */
+    class FrameFFT
+    {
+    public:
+        int getSize() const noexcept { return transform->getSize(); }
+
+        void performRealOnlyForwardTransform (SampleType* inOutData, const bool onlyCalculateNonNegativeFrequencies = false) const noexcept
+        {
+            typename TransformWorkspaces::ScopedSlot workspace (*workspaces);
+            transform->performRealOnlyForwardTransform (inOutData, onlyCalculateNonNegativeFrequencies, workspace->fft.get());
+        }
+
+        void performRealOnlyInverseTransform (SampleType* inOutData) const noexcept
+        {
+            typename TransformWorkspaces::ScopedSlot workspace (*workspaces);
+            transform->performRealOnlyInverseTransform (inOutData, workspace->fft.get());
+        }
+
+        void performFrequencyOnlyForwardTransform (SampleType* inOutData) const noexcept
+        {
+            typename TransformWorkspaces::ScopedSlot workspace (*workspaces);
+            transform->performFrequencyOnlyForwardTransform (inOutData, workspace->fft.get());
+        }
+
+    private:
+        friend class BasicOverlappingFFTProcessor;
+        const FFTBackend<SampleType>* transform = nullptr;
+        const TransformWorkspaces* workspaces = nullptr;
+    };
+
+    /** Read-only access to the analysis window of the current frame, which is shared with other processors (see WindowCache). */
+    class FrameWindow
+    {
+    public:
+        size_t size() const noexcept { return values->size(); }
+        const SampleType* data() const noexcept { return values->data(); }
+        SampleType operator[] (const size_t index) const noexcept { return (*values)[index]; }
+
+        typename std::vector<SampleType>::const_iterator begin() const noexcept { return values->begin(); }
+        typename std::vector<SampleType>::const_iterator end() const noexcept { return values->end(); }
+
+    private:
+        friend class BasicOverlappingFFTProcessor;
+        const std::vector<SampleType>* values = nullptr;
+    };
+
+    /**
+     Asymmetric low-delay windows after Mauler and Martin: the analysis window rises slowly over the whole frame (half of
+     a long square root Hann window) and falls within the last synthesisLength / 2 samples. The synthesis window is zero
+     except for the last synthesisLength samples, and is chosen so the product of both windows is a Hann window of
+     synthesisLength samples, which is compensated for the hopSize. So an unaltered frame is reconstructed perfectly,
+     if synthesisLength is a multiple of the hopSize (and at least twice the hopSize).
+     */
+    static void createLowDelayWindows (std::vector<SampleType>& analysisWindow, std::vector<SampleType>& synthesisWindow,
+                                       const Resolution resolution, const int synthesisLength)
+    {
+        const int size = resolution.fftSize;
+        const int length = jmin (synthesisLength, size);
+        const int halfLength = length / 2;
+        const int fallStart = size - halfLength;
+        const int synthesisStart = size - length;
+        const double hopSizeCompensateFactor = 2.0 * resolution.hopSize / length;
+
+        auto hann = [] (const int i, const int hannSize) { return 0.5 * (1.0 - std::cos (2.0 * MathConstants<double>::pi * i / hannSize)); };
+
+        for (int i = 0; i < size; ++i)
+        {
+            const double analysis = i < fallStart ? std::sqrt (hann (i, 2 * fallStart)) : std::sqrt (hann (i - synthesisStart, length));
+            double synthesis = 0.0;
+
+            if (i >= fallStart)
+                synthesis = std::sqrt (hann (i - synthesisStart, length));
+            else if (i >= synthesisStart && analysis > 0.0)
+                synthesis = hann (i - synthesisStart, length) / analysis;
+
+            analysisWindow[(size_t) i] = (SampleType) analysis;
+            synthesisWindow[(size_t) i] = (SampleType) (hopSizeCompensateFactor * synthesis);
+        }
+    }
+
+    /**
+     Calls `processFrame()` for the channels of the frame in `fftInOutBuffer`, on the worker threads if there are some,
+     like the default `processFrameInBuffer()`. For subclasses which prepare something for all channels of a frame first.
+     */
+    void processFrameChannels (const int maxNumChannels)
+    {
+        processChannels (maxNumChannels);
+    }
+
+    /**
+     Treats the given number of samples before the first input sample as silence, so the first frame ends that many
+     samples earlier than after a whole fftSize. E.g. for overlap-save, whose synthesis window only keeps the last
+     hopSize samples of a frame, a pre-roll of fftSize - hopSize samples lets the first frame produce the output of the
+     first input samples. Has to be called before `prepare()`, and has to be less than the fftSize (default: 0).
+     */
+    void setPreRollLength (const int numSamples)
+    {
+        jassert (numSamples >= 0);
+        preRollLength = numSamples;
+    }
+
+    /**
+     Returns false if the input channel was silent during the current frame, see `setActivityDetection()`. Its data is zero
+     then, and it won't be added to the output, so the callbacks can skip it. Channels without input are always active.
+     */
+    bool isChannelActive (const int channel) const noexcept
+    {
+        return frameActiveChannels == nullptr || channel >= nChIn || frameActiveChannels[channel];
+    }
+
+    /**
+     Returns the value of a frame parameter for the current frame, interpolated to its centre, see `setNumFrameParameters()`.
+     Outside of `process()` (e.g. in the OfflineRenderer), it's the latest value set with `setFrameParameter()`.
+     */
+    float getFrameParameter (const int index) const noexcept
+    {
+        return frameParameterValues != nullptr ? frameParameterValues[index] : frameParameters.getValue (index);
+    }
+
+    /**
+     Returns the number of past frames in the spectral history, which the spectral callbacks can access with
+     `getPastSpectra()`, see `setSpectralHistoryLength()`. It grows up to the history length after `prepare()`, and
+     starts at 0 again after a resolution change.
+     */
+    int getNumPastSpectra() const noexcept
+    {
+        return isHistoryFrame ? numPastSpectra : 0;
+    }
+
+    /**
+     Returns the input spectra (split-complex, fftSize / 2 + 1 bins) of a past frame, only call it from the spectral
+     callbacks. The channels are those of the forward transforms: the input channels in matrix domain, otherwise as
+     many as the frame has. In matrix domain, `inputSpectra` are the ones of the current frame, in the other domains
+     those of the current frame are returned for 0 frames ago (before they're changed by the callback).
+     @param framesAgo 1 for the previous frame, up to `getNumPastSpectra()`
+     */
+    const SplitComplexBuffer<SampleType>& getPastSpectra (const int framesAgo) const noexcept
+    {
+        jassert (framesAgo >= 0 && framesAgo <= getNumPastSpectra());
+
+        if (framesAgo == 0)
+            return getCurrentSpectra();
+
+        const int size = spectralHistory.size();
+        return *spectralHistory.getUnchecked ((newestPastSpectra - (framesAgo - 1) + size) % size);
+    }
+
+    // these describe the frame which is currently processed, they change with setResolution()
+    FrameFFT fft;
+    FrameWindow window;
+    AudioBuffer<SampleType> fftInOutBuffer;
+    SplitComplexBuffer<SampleType> spectrumBuffer;
+    SplitComplexBuffer<SampleType> inputSpectra; // FrameDomain::matrix only
+    SplitComplexBuffer<SampleType> outputSpectra; // FrameDomain::matrix only
+    int fftSize;
+    int hopSize;
+
+private:
+    template <typename OtherSampleType>
+    friend class OfflineRenderer;
+
+    int nChIn;
+    int nChOut;
+
+    int maximumFftSize;
+    int deferredHopSize;
+    int synthesisWindowLength = 0;
+    int preRollLength = 0;
+
+    SharedResourcePointer<FFTPlanCache<SampleType>> planCache;
+    SharedResourcePointer<BatchedFFTCache<SampleType>> batchedFFTCache;
+    SharedResourcePointer<WindowCache<SampleType>> windowCache;
+    OwnedArray<Configuration> configurations;
+    std::atomic<Configuration*> pendingConfiguration { nullptr };
+    int64 numConfigurationsCreated = 0;
+    SampleType windowSum = 1;
+
+    Stream activeStream;
+    Stream fadingStream;
+
+    AudioBuffer<SampleType> inputBuffer;
+    int inputBufferMask;
+    int64 inputPosition;
+
+    struct ChannelJob : public FrameWorkerPool::Job
+    {
+        ChannelJob (BasicOverlappingFFTProcessor& p) : processor (p) {}
+
+        /** For batched transforms, the task index is the index of the batch, otherwise the channel. */
+        void runTask (const int channel) override
+        {
+            switch (task)
+            {
+                case ChannelTask::processFrame: if (processor.isChannelActive (channel)) processor.processFrame (channel, channelData[channel]); break;
+                case ChannelTask::forwardTransform: processor.forwardTransform (channel, channelData[channel]); break;
+                case ChannelTask::inverseTransform: processor.inverseTransform (channel, channelData[channel]); break;
+                case ChannelTask::batchedForwardTransform: processor.batchedForwardTransform (channel); break;
+                case ChannelTask::batchedInverseTransform: processor.batchedInverseTransform (channel); break;
+            }
+        }
+
+        BasicOverlappingFFTProcessor& processor;
+        ChannelTask task = ChannelTask::processFrame;
+        SampleType** channelData = nullptr;
+    };
+
+    ChannelJob channelJob { *this };
+    std::unique_ptr<FrameWorkerPool> workerPool;
+    const BatchedRealFFT<SampleType>* batchedFFT = nullptr;
+
+    // the channels of the batched transforms of the current frame, see gatherBatchedChannels()
+    HeapBlock<int> batchedChannels;
+    HeapBlock<SampleType*> batchedChannelData;
+    int numBatchedChannels = 0;
+
+    AudioBuffer<SampleType> outputBuffer;
+    int outputBufferMask;
+    int64 outputReadPosition;
+
+    // the memory of inputBuffer, fftInOutBuffer, outputBuffer and the background frames' buffers, see allocateBuffers()
+    static constexpr int bufferAlignmentInBytes = 64;
+    HeapBlock<SampleType> bufferMemory;
+    size_t bufferMemorySize = 0;
+
+    struct BackgroundFrame
+    {
+        AudioBuffer<SampleType> buffer;
+        FrameInfo info;
+        HeapBlock<bool> activeChannels;
+        HeapBlock<float> parameters;
+    };
+
+    FrameScheduling scheduling = FrameScheduling::synchronous;
+    FrameDomain domain = FrameDomain::time;
+    OwnedArray<BackgroundFrame> backgroundFrames;
+    std::atomic<int64> numFramesSubmitted { 0 };
+    std::atomic<int64> numFramesProcessed { 0 };
+    int64 numFramesWrittenBack = 0;
+    BackgroundThread backgroundThread { *this };
+
+    FrameInfo pendingFrame;
+    int numPendingFrameTasks = 0;
+    int numPendingFrameForwardTransforms = 0;
+    int nextPendingFrameTask = 0;
+    double pendingFrameTaskBudget = 0.0;
+
+    SpectrumTap* spectrumTap = nullptr;
+    HeapBlock<SampleType> tapMagnitudes;
+
+    ActivityDetection activityDetection = ActivityDetection::off;
+    SampleType activityThreshold = 0;
+    int activityHoldTime = 0;
+    int activityHoldLength = 0;
+    HeapBlock<int64> lastActivePositions; // input position up to which each input channel had some signal
+    HeapBlock<bool> frameActivity; // the activity of the synchronous or amortized frame
+    const bool* frameActiveChannels = nullptr; // the activity of the frame which is currently processed
+
+    int spectralHistoryLength = 0;
+    OwnedArray<SplitComplexBuffer<SampleType>> spectralHistory; // ring of the input spectra of the past frames
+    SplitComplexBuffer<SampleType> currentSpectra; // the current frame's spectra for the history, not in matrix domain
+    int newestPastSpectra = 0;
+    int numPastSpectra = 0;
+    int64 historySerialNumber = -1; // the configuration of the frames in the history
+    int64 frameSerialNumber = -1; // the configuration of the frame which is currently processed
+    bool isHistoryFrame = false;
+
+    FrameParameters frameParameters;
+    HeapBlock<float> frameParameterSnapshot; // the parameters of the synchronous or amortized frame
+    const float* frameParameterValues = nullptr; // the parameters of the frame which is currently processed
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    ProcessorStatistics statistics;
+   #endif
+
+    JUCE_DECLARE_NON_COPYABLE (BasicOverlappingFFTProcessor)
+};
+
+/** The processor in single precision. */
+using OverlappingFFTProcessor = BasicOverlappingFFTProcessor<float>;
@@ -0,0 +1,607 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include "OverlappingFFTProcessor.h"
+
+/**
+ Uniformly partitioned convolution (overlap-save) with long impulse responses, e.g. for room correction or reverb.
+ The impulse response is split into partitions of blockSize samples, whose spectra are computed when it's loaded.
+ Each frame of 2 * blockSize samples (hopSize blockSize, rectangular analysis window) is transformed once and kept in a
+ frequency-domain delay line, the output spectrum is the sum of the delayed spectra multiplied with the partitions'
+ spectra (SIMD kernels of SplitComplexBuffer), and the synthesis window discards the wrapped-around first half.
+ The first frame starts blockSize samples before the input (a pre-roll of silence), so no output is left out.
+ The latency is blockSize - 1 samples. With a smaller latency (e.g. 0), the first taps of the impulse response
+ are convolved directly in the time domain, up to the point from which on the partitions are in time.
+
+ Channel c is convolved with channel c of the impulse response, or with its last channel if it has fewer, so a mono
+ impulse response is used for all channels. The channels are processed in parallel if there are worker threads, see
+ `setNumWorkerThreads()`. Only `FrameScheduling::synchronous` is supported, and the resolution must not be changed.
+ As each frame depends on the previous ones, the convolution can't be used with the OfflineRenderer.
+ With `setActivityDetection()`, use a hold time of at least the length of the impulse response plus blockSize, so the
+ delay line of a channel is silent before its frames are skipped.
+
+ `loadImpulseResponse()` can be called while processing: the spectra are computed on the calling thread, the audio
+ thread picks them up at its next frame without allocating or locking, and crossfades to them within one block.
+
+ For long impulse responses with low latency, use the PartitionedConvolution instead, which combines small
+ partitions at the beginning of the impulse response with larger ones for its tail.
+
+ @code
+ UniformPartitionedConvolution convolution (512, 4 * 48000); // 4 s impulse response, latency 511 samples
+ convolution.prepare (48000.0, 512, 2, 2);
+ convolution.loadImpulseResponse (impulseResponse); // any thread but the audio thread
+ @endcode
+ */
+template <typename SampleType>
+class BasicUniformPartitionedConvolution : public BasicOverlappingFFTProcessor<SampleType>
+{
+public:
+    using Base = BasicOverlappingFFTProcessor<SampleType>;
+    using typename Base::Resolution;
+
+    /** Constructor
+     @param partitionSize the blockSize of the partitions, a power of 2 is fastest
+     @param numberOfTaps the number of taps of the impulse response which are convolved, longer ones are truncated
+     @param latencyInSamples the latency of the convolution, at most partitionSize - 1 (the default for -1)
+     @param firstTapToUse the first tap which is convolved, taps before are left out (e.g. they are convolved elsewhere)
+     */
+    BasicUniformPartitionedConvolution (const int partitionSize, const int numberOfTaps, const int latencyInSamples = -1, const int firstTapToUse = 0)
+    : Base (Resolution { 2 * partitionSize, partitionSize }), blockSize (partitionSize), firstTap (firstTapToUse), numTaps (numberOfTaps),
+      latency (latencyInSamples < 0 ? partitionSize - 1 : latencyInSamples)
+    {
+        // the partitions can't be processed with more latency than one block, delay the output instead
+        jassert (latency <= blockSize - 1);
+        jassert (firstTap >= 0 && numTaps > 0);
+
+        // taps which are due before the partitions are in time are convolved in the time domain
+        fftFirstTap = jmax (firstTap, blockSize - 1 - latency);
+        headLength = jmin (fftFirstTap, firstTap + numTaps) - firstTap;
+
+        // the taps of the partitions are shifted by the difference between their latency and the convolution's latency
+        const int leadingZeros = fftFirstTap + latency - (blockSize - 1);
+        numLeadingPartitions = leadingZeros / blockSize;
+        partitionOffset = leadingZeros % blockSize;
+
+        const int numFftTaps = jmax (0, firstTap + numTaps - fftFirstTap);
+        maxNumPartitions = (partitionOffset + numFftTaps + blockSize - 1) / blockSize;
+        delayLineLength = numLeadingPartitions + jmax (1, maxNumPartitions);
+
+        this->setSynthesisWindowLength (blockSize);
+
+        // the first frame ends after blockSize samples, so its second half is the output of the first input samples
+        this->setPreRollLength (blockSize);
+    }
+
+    ~BasicUniformPartitionedConvolution() {}
+
+    int getPartitionSize() const { return blockSize; }
+
+    /**
+     Returns the latency of the convolution, which was passed to the constructor. The frames have a latency of
+     blockSize - 1 samples, the taps convolved in the time domain make up for the difference.
+     */
+    int getLatencyInSamples() const override { return latency; }
+
+    /** Like `OverlappingFFTProcessor::getMemoryFootprintBytes()`, including the delay line and the loaded impulse responses. */
+    size_t getMemoryFootprintBytes() const
+    {
+        size_t numBytes = Base::getMemoryFootprintBytes() - sizeof (Base) + sizeof (*this);
+        numBytes += delayLine.getSizeInBytes() + accumulator.getSizeInBytes();
+        numBytes += getSizeInBytes (previousOutput) + getSizeInBytes (headHistory) + getSizeInBytes (headOutput);
+
+        for (auto* response : impulseResponses)
+            numBytes += sizeof (ImpulseResponse) + response->partitions.getSizeInBytes() + getSizeInBytes (response->head);
+
+        return numBytes;
+    }
+
+    /**
+     Computes the spectra of a new impulse response and hands them over to the audio thread, which crossfades to them
+     within one block. Call it from any thread but the audio thread, not concurrently with `prepare()`. Further calls
+     before the audio thread has picked up the impulse response replace it.
+     @param impulseResponse one channel for all channels, or one for each channel
+     */
+    void loadImpulseResponse (const AudioBuffer<SampleType>& impulseResponse)
+    {
+        jassert (impulseResponse.getNumChannels() > 0);
+        deleteRetiredImpulseResponses();
+
+        const int numIrChannels = impulseResponse.getNumChannels();
+        const int lastTap = jmin (impulseResponse.getNumSamples(), firstTap + numTaps);
+        auto* response = impulseResponses.add (new ImpulseResponse());
+
+        response->numChannels = numIrChannels;
+        response->head.setSize (numIrChannels, jmax (1, headLength));
+        response->head.clear();
+
+        for (int ch = 0; ch < numIrChannels; ++ch)
+            for (int i = 0; i < headLength && firstTap + i < lastTap; ++i)
+                response->head.setSample (ch, i, impulseResponse.getSample (ch, firstTap + i));
+
+        // the partitions only go up to the last tap which isn't zero
+        int numPartitions = 0;
+        for (int ch = 0; ch < numIrChannels; ++ch)
+            for (int tap = lastTap; --tap >= fftFirstTap;)
+                if (impulseResponse.getSample (ch, tap) != 0)
+                {
+                    numPartitions = jmax (numPartitions, (partitionOffset + tap - fftFirstTap) / blockSize + 1);
+                    break;
+                }
+
+        response->numPartitions = numPartitions;
+        response->partitions.setSize (jmax (1, numPartitions * numIrChannels), blockSize + 1);
+
+        HeapBlock<SampleType> partition (4 * (size_t) blockSize);
+        for (int p = 0; p < numPartitions; ++p)
+            for (int ch = 0; ch < numIrChannels; ++ch)
+            {
+                // the first partition starts with the leading zeros, the transform is zero-padded to 2 * blockSize
+                FloatVectorOperations::clear (partition.get(), 4 * blockSize);
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    const int tap = fftFirstTap + p * blockSize + i - partitionOffset;
+                    if (tap >= fftFirstTap && tap < lastTap)
+                        partition[i] = impulseResponse.getSample (ch, tap);
+                }
+
+                fft.performRealOnlyForwardTransform (partition.get(), true);
+                response->partitions.copyFromInterleaved (p * numIrChannels + ch, partition.get());
+            }
+
+        // an impulse response which hasn't been picked up by the audio thread yet can be deleted right away
+        if (auto* replacedResponse = pendingResponse.exchange (response))
+            impulseResponses.removeObject (replacedResponse);
+    }
+
+    /** Prepares the convolution. All memory is allocated here, `process()` never allocates. */
+    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels)
+    {
+        // frames are processed in order on the audio thread, see the class description
+        jassert (this->getFrameScheduling() == FrameScheduling::synchronous);
+
+        Base::prepare (sampleRate, maximumBlockSize, numInputChannels, numOutputChannels);
+
+        // nothing is running anymore: a pending impulse response is used right away
+        if (auto* nextResponse = pendingResponse.exchange (nullptr))
+        {
+            retire (currentResponse);
+            currentResponse = nextResponse;
+        }
+
+        retire (previousResponse);
+        previousResponse = nullptr;
+        isFading = false;
+
+        nChIn = numInputChannels;
+        nChOut = numOutputChannels;
+        numChannels = jmax (nChIn, nChOut);
+
+        delayLine.setSize (delayLineLength * numChannels, blockSize + 1);
+        accumulator.setSize (numChannels, blockSize + 1);
+        previousOutput.setSize (numChannels, 4 * blockSize);
+
+        // the input history of the time-domain taps reaches back to the last one
+        headReach = headLength > 0 ? latency + firstTap + headLength - 1 : 0;
+        headHistory.setSize (nChIn, headReach + maximumBlockSize);
+        headHistory.clear();
+        headOutput.setSize (2, maximumBlockSize);
+
+        numFrames = 0;
+        numSamplesProcessed = 0;
+    }
+
+    void process (const dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::ProcessContextNonReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::AudioBlock<const SampleType>& inputBlock, dsp::AudioBlock<SampleType>& outputBlock)
+    {
+        const auto L = (int) inputBlock.getNumSamples();
+        const auto numChIn = jmin (static_cast<int> (inputBlock.getNumChannels()), nChIn);
+
+        // the input is needed after the partitions have been processed, which might overwrite it
+        if (headLength > 0)
+        {
+            jassert (headReach + L <= headHistory.getNumSamples());
+
+            for (int ch = 0; ch < numChIn; ++ch)
+                FloatVectorOperations::copy (headHistory.getWritePointer (ch, headReach), inputBlock.getChannelPointer (ch), L);
+
+            for (int ch = numChIn; ch < nChIn; ++ch)
+                FloatVectorOperations::clear (headHistory.getWritePointer (ch, headReach), L);
+        }
+
+        Base::process (inputBlock, outputBlock);
+
+        if (headLength > 0)
+        {
+            const auto numChOut = jmin (static_cast<int> (outputBlock.getNumChannels()), nChOut, numChIn);
+            for (int ch = 0; ch < numChOut; ++ch)
+                addHead (ch, outputBlock.getChannelPointer (ch), L);
+
+            for (int ch = 0; ch < nChIn; ++ch)
+                std::memmove (headHistory.getWritePointer (ch), headHistory.getReadPointer (ch, L), (size_t) headReach * sizeof (SampleType));
+        }
+
+        numSamplesProcessed += L;
+
+        // the time-domain taps have been crossfaded as well, the previous impulse response isn't needed anymore
+        if (isFading && numSamplesProcessed >= fadeStart + blockSize)
+        {
+            retire (previousResponse);
+            previousResponse = nullptr;
+            isFading = false;
+        }
+    }
+
+private:
+    using FrameScheduling = typename Base::FrameScheduling;
+    using Base::fft;
+
+    /** The spectra of the partitions of an impulse response, and its taps which are convolved in the time domain. */
+    struct ImpulseResponse
+    {
+        SplitComplexBuffer<SampleType> partitions; // channel p * numChannels + ch holds partition p of channel ch
+        AudioBuffer<SampleType> head;
+        int numChannels = 0;
+        int numPartitions = 0;
+
+        // set by the audio thread as soon as it doesn't use the impulse response anymore
+        std::atomic<bool> isRetired { false };
+    };
+
+    /** Rectangular analysis window, the synthesis window discards the first half of the frames (overlap-save). */
+    void createWindows (std::vector<SampleType>& analysisWindow, std::vector<SampleType>& synthesisWindow, const Resolution resolution) override
+    {
+        std::fill (analysisWindow.begin(), analysisWindow.end(), (SampleType) 1);
+        std::fill (synthesisWindow.begin(), synthesisWindow.end(), (SampleType) 0);
+        std::fill (synthesisWindow.begin() + (resolution.fftSize - resolution.hopSize), synthesisWindow.end(), (SampleType) 1);
+    }
+
+    /** Picks up a new impulse response, and advances the delay line, before the channels are processed. */
+    void processFrameInBuffer (const int maxNumChannels) override
+    {
+        isFadingFrame = false;
+
+        // a new impulse response has to wait until the time-domain taps have finished the last crossfade
+        if (! isFading)
+            if (auto* nextResponse = pendingResponse.exchange (nullptr))
+            {
+                previousResponse = currentResponse;
+                currentResponse = nextResponse;
+                isFading = isFadingFrame = true;
+
+                // after the pre-roll of blockSize samples, the frame ends at input sample (numFrames + 1) * blockSize, its
+                // second half is written to the output from blockSize samples before that, plus the latency of blockSize - 1 samples
+                fadeStart = (numFrames + 1) * blockSize - 1;
+            }
+
+        currentSlot = (int) (numFrames++ % delayLineLength);
+        this->processFrameChannels (maxNumChannels);
+    }
+
+    void processFrame (const int channel, SampleType* data) override
+    {
+        fft.performRealOnlyForwardTransform (data, true);
+        delayLine.copyFromInterleaved (currentSlot * numChannels + channel, data);
+
+        convolve (currentResponse, channel, data);
+
+        if (isFadingFrame)
+        {
+            SampleType* previous = previousOutput.getWritePointer (channel);
+            convolve (previousResponse, channel, previous);
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                const SampleType gain = (SampleType) (i + 1) / blockSize;
+                data[blockSize + i] = previous[blockSize + i] + gain * (data[blockSize + i] - previous[blockSize + i]);
+            }
+        }
+    }
+
+    /** Sums up the products of the delayed spectra and the partitions of an impulse response, and transforms the sum back into `destination`. */
+    void convolve (const ImpulseResponse* response, const int channel, SampleType* destination)
+    {
+        if (response == nullptr)
+        {
+            FloatVectorOperations::clear (destination, 2 * blockSize);
+            return;
+        }
+
+        FloatVectorOperations::clear (accumulator.getRealPointer (channel), blockSize + 1);
+        FloatVectorOperations::clear (accumulator.getImagPointer (channel), blockSize + 1);
+
+        const int irChannel = jmin (channel, response->numChannels - 1);
+        const int numPartitions = (int) jmin ((int64) response->numPartitions, numFrames - numLeadingPartitions);
+
+        for (int p = 0; p < numPartitions; ++p)
+        {
+            const int slot = (currentSlot - numLeadingPartitions - p + 2 * delayLineLength) % delayLineLength;
+            accumulator.addProductOf (channel, delayLine, slot * numChannels + channel, response->partitions, p * response->numChannels + irChannel);
+        }
+
+        accumulator.copyToInterleaved (channel, destination);
+        fft.performRealOnlyInverseTransform (destination);
+    }
+
+    /** Adds the time-domain taps of the channel, crossfaded like the partitions if there's a new impulse response. */
+    void addHead (const int channel, SampleType* output, const int numSamples)
+    {
+        const int64 blockStart = numSamplesProcessed;
+        const bool fadesWithinBlock = isFading && blockStart + numSamples > fadeStart && blockStart < fadeStart + blockSize;
+
+        if (! fadesWithinBlock)
+        {
+            // before the crossfade has started, the previous impulse response is still in use
+            const auto* response = isFading && blockStart + numSamples <= fadeStart ? previousResponse : currentResponse;
+            if (response != nullptr)
+                convolveHead (*response, channel, output, numSamples);
+
+            return;
+        }
+
+        SampleType* current = headOutput.getWritePointer (0);
+        SampleType* previous = headOutput.getWritePointer (1);
+        FloatVectorOperations::clear (current, numSamples);
+        FloatVectorOperations::clear (previous, numSamples);
+
+        if (currentResponse != nullptr)
+            convolveHead (*currentResponse, channel, current, numSamples);
+
+        if (previousResponse != nullptr)
+            convolveHead (*previousResponse, channel, previous, numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const SampleType gain = (SampleType) jlimit ((int64) 0, (int64) blockSize, blockStart + i - fadeStart + 1) / blockSize;
+            output[i] += previous[i] + gain * (current[i] - previous[i]);
+        }
+    }
+
+    /** Adds the direct convolution of the input history with the time-domain taps of an impulse response. */
+    void convolveHead (const ImpulseResponse& response, const int channel, SampleType* output, const int numSamples)
+    {
+        const SampleType* taps = response.head.getReadPointer (jmin (channel, response.numChannels - 1));
+        const SampleType* history = headHistory.getReadPointer (channel, headReach);
+
+        for (int i = 0; i < headLength; ++i)
+            if (taps[i] != 0)
+                FloatVectorOperations::addWithMultiply (output, history - (latency + firstTap + i), taps[i], numSamples);
+    }
+
+    static size_t getSizeInBytes (const AudioBuffer<SampleType>& buffer) noexcept
+    {
+        return (size_t) buffer.getNumChannels() * (size_t) buffer.getNumSamples() * sizeof (SampleType);
+    }
+
+    static void retire (ImpulseResponse* response)
+    {
+        if (response != nullptr)
+            response->isRetired = true;
+    }
+
+    void deleteRetiredImpulseResponses()
+    {
+        for (int i = impulseResponses.size(); --i >= 0;)
+            if (impulseResponses.getUnchecked (i)->isRetired.load())
+                impulseResponses.remove (i);
+    }
+
+    const int blockSize;
+    const int firstTap;
+    const int numTaps;
+    const int latency;
+    int fftFirstTap;
+    int headLength;
+    int numLeadingPartitions;
+    int partitionOffset;
+    int maxNumPartitions;
+    int delayLineLength;
+
+    int nChIn = 0;
+    int nChOut = 0;
+    int numChannels = 0;
+
+    OwnedArray<ImpulseResponse> impulseResponses;
+    std::atomic<ImpulseResponse*> pendingResponse { nullptr };
+
+    // only used by the audio thread
+    ImpulseResponse* currentResponse = nullptr;
+    ImpulseResponse* previousResponse = nullptr;
+    bool isFading = false;
+    bool isFadingFrame = false;
+    int64 fadeStart = 0;
+    int64 numFrames = 0;
+    int64 numSamplesProcessed = 0;
+    int currentSlot = 0;
+
+    SplitComplexBuffer<SampleType> delayLine; // channel slot * numChannels + ch holds a past spectrum of channel ch
+    SplitComplexBuffer<SampleType> accumulator;
+    AudioBuffer<SampleType> previousOutput;
+
+    AudioBuffer<SampleType> headHistory;
+    AudioBuffer<SampleType> headOutput;
+    int headReach = 0;
+
+    JUCE_DECLARE_NON_COPYABLE (BasicUniformPartitionedConvolution)
+};
+
+/** The uniformly partitioned convolution in single precision. */
+using UniformPartitionedConvolution = BasicUniformPartitionedConvolution<float>;
+
+//==============================================================================
+/**
+ Non-uniformly partitioned convolution: the beginning of the impulse response is convolved with small partitions,
+ which keep the latency low, and the tail with larger ones, which need far fewer operations per sample. Each partition
+ size is a BasicUniformPartitionedConvolution covering a segment of the impulse response, which starts as soon as its
+ partitions can be in time, e.g. for partition sizes 64, 512 and 4096 without latency: taps 0 to 62 in the time domain,
+ up to 510 with 64 samples, up to 4094 with 512 samples, and the rest with 4096 samples.
+ The latency is the smallest partition size - 1, or 0 with `zeroLatency`. A single partition size is a uniform convolution.
+
+ The larger partitions are processed all at once every few host blocks, so give the convolutions some worker threads
+ with `setNumWorkerThreads()` for many channels.
+
+ @code
+ PartitionedConvolution convolution ({ 64, 512, 4096 }, 3 * 48000, true);
+ convolution.prepare (48000.0, 512, 16, 16);
+ convolution.loadImpulseResponse (impulseResponses); // any thread but the audio thread
+ @endcode
+ */
+template <typename SampleType>
+class BasicPartitionedConvolution
+{
+public:
+    /** Constructor
+     @param partitionSizes the partition sizes, ascending, each one should be at least twice the one before
+     @param maximumImpulseResponseLength the length of the longest impulse response which will be loaded
+     @param zeroLatency if true, the first taps of the impulse response are convolved in the time domain, so there's no latency
+     */
+    BasicPartitionedConvolution (const Array<int>& partitionSizes, const int maximumImpulseResponseLength, const bool zeroLatency = false)
+    {
+        jassert (partitionSizes.size() > 0);
+        latency = zeroLatency ? 0 : partitionSizes[0] - 1;
+
+        int segmentStart = 0;
+        for (int i = 0; i < partitionSizes.size() && segmentStart < maximumImpulseResponseLength; ++i)
+        {
+            jassert (i == 0 || partitionSizes[i] > partitionSizes[i - 1]);
+
+            // a segment ends where the next partition size can take over, but has at least one partition
+            int segmentEnd = maximumImpulseResponseLength;
+            if (i + 1 < partitionSizes.size())
+                segmentEnd = jmin (segmentEnd, jmax (segmentStart + partitionSizes[i], partitionSizes[i + 1] - 1 - latency));
+
+            segments.add (new BasicUniformPartitionedConvolution<SampleType> (partitionSizes[i], segmentEnd - segmentStart, latency, segmentStart));
+            segmentStart = segmentEnd;
+        }
+    }
+
+    ~BasicPartitionedConvolution() {}
+
+    int getLatencyInSamples() const { return latency; }
+
+    /** Returns the memory footprint of all segments, see `UniformPartitionedConvolution::getMemoryFootprintBytes()`. */
+    size_t getMemoryFootprintBytes() const
+    {
+        size_t numBytes = sizeof (*this);
+        numBytes += (size_t) (inputCopy.getNumChannels() * inputCopy.getNumSamples() + segmentOutput.getNumChannels() * segmentOutput.getNumSamples()) * sizeof (SampleType);
+
+        for (auto* segment : segments)
+            numBytes += segment->getMemoryFootprintBytes();
+
+        return numBytes;
+    }
+
+    int getNumSegments() const { return segments.size(); }
+    const BasicUniformPartitionedConvolution<SampleType>& getSegment (const int index) const { return *segments[index]; }
+
+    /**
+     Sets the number of additional threads of each segment, which help processing the channels of its frames in parallel.
+     Don't call this while `process()` might be running. For the spin time of the workers and its CPU cost, see
+     `BasicOverlappingFFTProcessor::setNumWorkerThreads()`.
+     */
+    void setNumWorkerThreads (const int numWorkerThreads, const double workerSpinTimeInMilliseconds = FrameWorkerPool::defaultSpinTimeInMilliseconds)
+    {
+        for (auto* segment : segments)
+            segment->setNumWorkerThreads (numWorkerThreads, workerSpinTimeInMilliseconds);
+    }
+
+    /** Loads a new impulse response, see `BasicUniformPartitionedConvolution::loadImpulseResponse()`. */
+    void loadImpulseResponse (const AudioBuffer<SampleType>& impulseResponse)
+    {
+        for (auto* segment : segments)
+            segment->loadImpulseResponse (impulseResponse);
+    }
+
+    /** Prepares the convolution. All memory is allocated here, `process()` never allocates. */
+    void prepare (const double sampleRate, const int maximumBlockSize, const int numInputChannels, const int numOutputChannels)
+    {
+        for (auto* segment : segments)
+            segment->prepare (sampleRate, maximumBlockSize, numInputChannels, numOutputChannels);
+
+        nChIn = numInputChannels;
+        nChOut = numOutputChannels;
+
+        // the first segment processes in place, the others need a copy of the input
+        inputCopy.setSize (nChIn, segments.size() > 1 ? maximumBlockSize : 0);
+        segmentOutput.setSize (nChOut, segments.size() > 1 ? maximumBlockSize : 0);
+    }
+
+    void process (const dsp::ProcessContextReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::ProcessContextNonReplacing<SampleType>& context)
+    {
+        process (context.getInputBlock(), context.getOutputBlock());
+    }
+
+    void process (const dsp::AudioBlock<const SampleType>& inputBlock, dsp::AudioBlock<SampleType>& outputBlock)
+    {
+        const auto L = (int) inputBlock.getNumSamples();
+        const auto numChIn = jmin (static_cast<int> (inputBlock.getNumChannels()), nChIn);
+        const auto numChOut = jmin (static_cast<int> (outputBlock.getNumChannels()), nChOut);
+
+        if (segments.size() > 1)
+        {
+            inputCopy.clear();
+            for (int ch = 0; ch < numChIn; ++ch)
+                FloatVectorOperations::copy (inputCopy.getWritePointer (ch), inputBlock.getChannelPointer (ch), L);
+        }
+
+        segments.getUnchecked (0)->process (inputBlock, outputBlock);
+
+        for (int i = 1; i < segments.size(); ++i)
+        {
+            dsp::AudioBlock<SampleType> input (inputCopy);
+            dsp::AudioBlock<SampleType> output (segmentOutput);
+            auto segmentOutputBlock = output.getSubBlock (0, (size_t) L);
+            segments.getUnchecked (i)->process (input.getSubBlock (0, (size_t) L), segmentOutputBlock);
+
+            for (int ch = 0; ch < numChOut; ++ch)
+                FloatVectorOperations::add (outputBlock.getChannelPointer (ch), segmentOutput.getReadPointer (ch), L);
+        }
+    }
+
+private:
+    OwnedArray<BasicUniformPartitionedConvolution<SampleType>> segments;
+    int latency;
+
+    int nChIn = 0;
+    int nChOut = 0;
+    AudioBuffer<SampleType> inputCopy;
+    AudioBuffer<SampleType> segmentOutput;
+
+    JUCE_DECLARE_NON_COPYABLE (BasicPartitionedConvolution)
+};
+
+/** The non-uniformly partitioned convolution in single precision. */
+using PartitionedConvolution = BasicPartitionedConvolution<float>;
@@ -13,12 +13,18 @@
 
 //==============================================================================
 OverlappingFFTProcessorDemoAudioProcessorEditor::OverlappingFFTProcessorDemoAudioProcessorEditor (OverlappingFFTProcessorDemoAudioProcessor& p)
-    : AudioProcessorEditor (&p), processor (p)
+    : AudioProcessorEditor (&p), processor (p), spectrogram (p.getSpectrumTap())
 {
+    addAndMakeVisible (spectrogram);
+
     // Make sure that before the constructor has finished, you've set the
     // editor's size to whatever you need it to be.
-    setSize (400, 300);
+    setSize (560, 300 + spectrogramHeight + 10);
 
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    // the statistics of the processor are shown live
+    startTimerHz (10);
+   #endif
 }
 
 OverlappingFFTProcessorDemoAudioProcessorEditor::~OverlappingFFTProcessorDemoAudioProcessorEditor()
@@ -33,11 +39,93 @@ void OverlappingFFTProcessorDemoAudioProcessorEditor::paint (Graphics& g)
 
     g.setColour (Colours::white);
     g.setFont (15.0f);
-    g.drawFittedText ("OverlappingFFTProcessorDemo", getLocalBounds(), Justification::centred, 1);
+
+    auto bounds = getLocalBounds().reduced (10);
+    bounds.removeFromBottom (spectrogramHeight + 10);
+    g.drawFittedText ("OverlappingFFTProcessorDemo", bounds.removeFromTop (25), Justification::centred, 1);
+
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    const auto& statistics = processor.getFFTProcessor().getStatistics();
+    g.setFont (Font (Font::getDefaultMonospacedFontName(), 12.0f, Font::plain));
+
+    g.drawText (String ("stage").paddedRight (' ', 18) + String ("mean").paddedLeft (' ', 10) + String ("max").paddedLeft (' ', 10)
+                + "  histogram (" + ProcessorStatistics::getCounterName() + ", log2 buckets)",
+                bounds.removeFromTop (20), Justification::centredLeft);
+
+    // the histograms show the same range of buckets
+    int firstBucket = AtomicHistogram::numBuckets, lastBucket = 0;
+    for (int stage = 0; stage < ProcessorStatistics::numStages; ++stage)
+    {
+        const auto& histogram = statistics.getHistogram ((ProcessorStatistics::Stage) stage);
+        for (int bucket = 0; bucket < AtomicHistogram::numBuckets; ++bucket)
+            if (histogram.getCount (bucket) > 0)
+            {
+                firstBucket = jmin (firstBucket, bucket);
+                lastBucket = jmax (lastBucket, bucket);
+            }
+    }
+
+    for (int stage = 0; stage < ProcessorStatistics::numStages; ++stage)
+    {
+        const auto& histogram = statistics.getHistogram ((ProcessorStatistics::Stage) stage);
+        auto row = bounds.removeFromTop (20);
+
+        g.setColour (Colours::white);
+        g.drawText (String (ProcessorStatistics::getStageName ((ProcessorStatistics::Stage) stage)).paddedRight (' ', 18)
+                    + String (roundToInt (histogram.getMean())).paddedLeft (' ', 10)
+                    + String ((int64) histogram.getMaximum()).paddedLeft (' ', 10),
+                    row.removeFromLeft (260), Justification::centredLeft);
+
+        if (lastBucket < firstBucket)
+            continue;
+
+        uint64 maxCount = 1;
+        for (int bucket = firstBucket; bucket <= lastBucket; ++bucket)
+            maxCount = jmax (maxCount, histogram.getCount (bucket));
+
+        const float barWidth = (float) row.getWidth() / (lastBucket - firstBucket + 1);
+        g.setColour (Colours::orange);
+        for (int bucket = firstBucket; bucket <= lastBucket; ++bucket)
+        {
+            const float height = (row.getHeight() - 4.0f) * histogram.getCount (bucket) / maxCount;
+            g.fillRect (row.getX() + (bucket - firstBucket) * barWidth, row.getBottom() - 2.0f - height, jmax (1.0f, barWidth - 1.0f), height);
+        }
+    }
+
+    bounds.removeFromTop (10);
+    g.setColour (Colours::white);
+
+    const auto& framesPerCall = statistics.getFramesPerProcessCall();
+    String frames ("frames per process():");
+    for (int numFrames = 0; numFrames < 8; ++numFrames)
+        if (framesPerCall.getCount (numFrames) > 0)
+            frames << "  " << numFrames << ": " << String (100.0 * framesPerCall.getCount (numFrames) / framesPerCall.getNumValues(), 1) << "%";
+
+    g.drawText (frames, bounds.removeFromTop (20), Justification::centredLeft);
+    g.drawText ("late frames: " + String ((int64) statistics.getNumLateFrames())
+                + "   stalled submissions: " + String ((int64) statistics.getNumStalledSubmissions())
+                + "   forced completions: " + String ((int64) statistics.getNumForcedFrameCompletions()),
+                bounds.removeFromTop (20), Justification::centredLeft);
+    g.drawText ("click to reset", bounds.removeFromTop (20), Justification::centredLeft);
+   #else
+    g.setFont (13.0f);
+    g.drawFittedText ("Define OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS=1 to see the statistics of the processor.", bounds, Justification::centred, 2);
+   #endif
 }
 
 void OverlappingFFTProcessorDemoAudioProcessorEditor::resized()
 {
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
+    spectrogram.setBounds (getLocalBounds().reduced (10).removeFromBottom (spectrogramHeight));
+}
+
+void OverlappingFFTProcessorDemoAudioProcessorEditor::mouseDown (const MouseEvent&)
+{
+   #if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+    processor.getFFTProcessor().getStatistics().reset();
+   #endif
+}
+
+void OverlappingFFTProcessorDemoAudioProcessorEditor::timerCallback()
+{
+    repaint();
 }
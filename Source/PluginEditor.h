@@ -12,11 +12,12 @@
 
 #include "../JuceLibraryCode/JuceHeader.h"
 #include "PluginProcessor.h"
+#include "SpectrogramComponent.h"
 
 //==============================================================================
 /**
 */
-class OverlappingFFTProcessorDemoAudioProcessorEditor  : public AudioProcessorEditor
+class OverlappingFFTProcessorDemoAudioProcessorEditor  : public AudioProcessorEditor, private Timer
 {
 public:
     OverlappingFFTProcessorDemoAudioProcessorEditor (OverlappingFFTProcessorDemoAudioProcessor&);
@@ -25,11 +26,17 @@ public:
     //==============================================================================
     void paint (Graphics&) override;
     void resized() override;
+    void mouseDown (const MouseEvent&) override;
 
 private:
+    void timerCallback() override;
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     OverlappingFFTProcessorDemoAudioProcessor& processor;
 
+    static constexpr int spectrogramHeight = 200;
+    SpectrogramComponent spectrogram;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OverlappingFFTProcessorDemoAudioProcessorEditor)
 };
@@ -24,6 +24,8 @@ OverlappingFFTProcessorDemoAudioProcessor::OverlappingFFTProcessorDemoAudioProce
                        )
 #endif
 {
+    myProcessor.setSpectrumTap (&spectrumTap);
+    addParameter (cutoff = new AudioParameterFloat ("cutoff", "Cutoff", 0.0f, 1.0f, 0.5f));
 }
 
 OverlappingFFTProcessorDemoAudioProcessor::~OverlappingFFTProcessorDemoAudioProcessor()
@@ -65,7 +67,9 @@ bool OverlappingFFTProcessorDemoAudioProcessor::isMidiEffect() const
 
 double OverlappingFFTProcessorDemoAudioProcessor::getTailLengthSeconds() const
 {
-    return 0.0;
+    // the last input samples leave the processor after its latency
+    const double sampleRate = getSampleRate();
+    return sampleRate > 0.0 ? myProcessor.getLatencyInSamples() / sampleRate : 0.0;
 }
 
 int OverlappingFFTProcessorDemoAudioProcessor::getNumPrograms()
@@ -98,12 +102,14 @@ void OverlappingFFTProcessorDemoAudioProcessor::prepareToPlay (double sampleRate
     // Use this method as the place to do any pre-playback
     // initialisation that you need..
     myProcessor.prepare (sampleRate, samplesPerBlock, 2, 2);
+    setLatencySamples (myProcessor.getLatencyInSamples());
 }
 
 void OverlappingFFTProcessorDemoAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
+    myProcessor.releaseResources();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -134,6 +140,9 @@ void OverlappingFFTProcessorDemoAudioProcessor::processBlock (AudioBuffer<float>
 {
     ScopedNoDenormals noDenormals;
 
+    // picked up without locking, the frames get the value ramped to their centre
+    myProcessor.setFrameParameter (MyProcessor::cutoffParameter, cutoff->get());
+
     dsp::AudioBlock<float> ab (buffer);
     dsp::ProcessContextReplacing<float> context (ab);
     myProcessor.process (context);
@@ -17,22 +17,28 @@
 class MyProcessor : public OverlappingFFTProcessor
 {
 public:
+    enum Parameters
+    {
+        cutoffParameter // the cutoff frequency relative to the Nyquist frequency
+    };
+
     MyProcessor () : OverlappingFFTProcessor (11, 2)
-    {}
+    {
+        setNumFrameParameters (1, 64, hopSize); // changes of the cutoff ramp over one hop
+        setFrameParameter (cutoffParameter, 0.5f);
+    }
     ~MyProcessor() {}
 
 private:
-    void processFrameInBuffer (const int maxNumChannels) override
+    void processFrame (const int channel, float* data) override
     {
-        for (int ch = 0; ch < maxNumChannels; ++ch)
-            fft.performRealOnlyForwardTransform (fftInOutBuffer.getWritePointer (ch), true);
+        fft.performRealOnlyForwardTransform (data, true);
 
-        // clear high frequency content
-        for (int ch = 0; ch < maxNumChannels; ++ch)
-            FloatVectorOperations::clear (fftInOutBuffer.getWritePointer (ch, fftSize / 2), fftSize / 2);
+        // clear high frequency content, the cutoff is interpolated to the centre of this frame
+        const int firstClearedValue = 2 * roundToInt (getFrameParameter (cutoffParameter) * fftSize / 2);
+        FloatVectorOperations::clear (data + firstClearedValue, fftSize - firstClearedValue);
 
-        for (int ch = 0; ch < maxNumChannels; ++ch)
-            fft.performRealOnlyInverseTransform (fftInOutBuffer.getWritePointer (ch));
+        fft.performRealOnlyInverseTransform (data);
     }
 };
 
@@ -79,8 +85,15 @@ public:
     void getStateInformation (MemoryBlock& destData) override;
     void setStateInformation (const void* data, int sizeInBytes) override;
 
+    //==============================================================================
+    MyProcessor& getFFTProcessor() { return myProcessor; }
+    SpectrumTap& getSpectrumTap() { return spectrumTap; }
+
 private:
+    // declared before the processor, so it outlives it
+    SpectrumTap spectrumTap { 2048, 128, 64 };
     MyProcessor myProcessor;
+    AudioParameterFloat* cutoff;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (OverlappingFFTProcessorDemoAudioProcessor)
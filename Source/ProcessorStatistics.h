@@ -0,0 +1,253 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+/*
+ Define OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS=1 to let the OverlappingFFTProcessor measure its stages,
+ see OverlappingFFTProcessor::getStatistics(). Otherwise the measurements aren't compiled in at all.
+ */
+#ifndef OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+ #define OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS 0
+#endif
+
+#if OVERLAPPINGFFTPROCESSOR_ENABLE_STATISTICS
+
+template <typename SampleType>
+class BasicOverlappingFFTProcessor;
+
+#if JUCE_INTEL
+ #if JUCE_MSVC
+  #include <intrin.h>
+ #else
+  #include <x86intrin.h>
+ #endif
+#endif
+
+/**
+ Lock-free histogram, which can be filled from several threads (e.g. the audio thread) and read from any other thread.
+ With `Scale::logarithmic`, bucket 0 counts the value 0 and bucket b > 0 the values in [2^(b - 1), 2^b),
+ with `Scale::linear`, bucket b counts the value b. Values beyond the last bucket are counted in the last bucket.
+ */
+class AtomicHistogram
+{
+public:
+    enum class Scale
+    {
+        linear,
+        logarithmic
+    };
+
+    static constexpr int numBuckets = 64;
+
+    AtomicHistogram (const Scale scaleToUse) : scale (scaleToUse)
+    {
+        reset();
+    }
+
+    void add (const uint64 value) noexcept
+    {
+        buckets[getBucket (value)].fetch_add (1, std::memory_order_relaxed);
+        numValues.fetch_add (1, std::memory_order_relaxed);
+        sum.fetch_add (value, std::memory_order_relaxed);
+
+        auto currentMaximum = maximum.load (std::memory_order_relaxed);
+        while (value > currentMaximum && ! maximum.compare_exchange_weak (currentMaximum, value, std::memory_order_relaxed))
+        {}
+    }
+
+    /** Clears the histogram. Values which are added at the same time might get lost. */
+    void reset() noexcept
+    {
+        for (auto& bucket : buckets)
+            bucket.store (0, std::memory_order_relaxed);
+
+        numValues.store (0, std::memory_order_relaxed);
+        sum.store (0, std::memory_order_relaxed);
+        maximum.store (0, std::memory_order_relaxed);
+    }
+
+    int getBucket (uint64 value) const noexcept
+    {
+        if (scale == Scale::linear)
+            return (int) jmin (value, (uint64) numBuckets - 1);
+
+        int bucket = 0;
+        for (; value > 0 && bucket < numBuckets - 1; value >>= 1)
+            ++bucket;
+
+        return bucket;
+    }
+
+    /** Returns the smallest value counted in the given bucket. */
+    uint64 getBucketStart (const int bucket) const noexcept
+    {
+        if (scale == Scale::linear || bucket == 0)
+            return (uint64) bucket;
+
+        return (uint64) 1 << (bucket - 1);
+    }
+
+    uint64 getCount (const int bucket) const noexcept { return buckets[bucket].load (std::memory_order_relaxed); }
+    uint64 getNumValues() const noexcept { return numValues.load (std::memory_order_relaxed); }
+    uint64 getMaximum() const noexcept { return maximum.load (std::memory_order_relaxed); }
+
+    double getMean() const noexcept
+    {
+        const auto n = getNumValues();
+        return n > 0 ? (double) sum.load (std::memory_order_relaxed) / n : 0.0;
+    }
+
+    Scale getScale() const noexcept { return scale; }
+
+private:
+    const Scale scale;
+    std::atomic<uint64> buckets[numBuckets];
+    std::atomic<uint64> numValues, sum, maximum;
+
+    JUCE_DECLARE_NON_COPYABLE (AtomicHistogram)
+};
+
+/**
+ Measurements of an OverlappingFFTProcessor: the duration of its stages, the number of frames per `process()` call,
+ and how often frames weren't ready in time. Everything can be read (and reset) from any thread while processing.
+ Durations are CPU cycles on x86 (time stamp counter), otherwise high resolution ticks, see `getCounterName()`.
+ */
+class ProcessorStatistics
+{
+public:
+    enum class Stage
+    {
+        process, /**< a whole `process()` call */
+        windowing, /**< copying a frame from the input history (with windowing) */
+        frameProcessing, /**< the frame callback (and the transforms), in amortized scheduling each of a frame's tasks on its own */
+        writeBack, /**< adding a frame to the output buffer */
+        outputRead, /**< reading the output samples of a `process()` call (and clearing them in the output buffer) */
+        numStages
+    };
+
+    static constexpr int numStages = (int) Stage::numStages;
+
+    static const char* getStageName (const Stage stage) noexcept
+    {
+        switch (stage)
+        {
+            case Stage::process: return "process";
+            case Stage::windowing: return "windowing";
+            case Stage::frameProcessing: return "frame processing";
+            case Stage::writeBack: return "write back";
+            case Stage::outputRead: return "output read";
+            default: return "";
+        }
+    }
+
+    static const char* getCounterName() noexcept
+    {
+       #if JUCE_INTEL
+        return "cycles";
+       #else
+        return "ticks";
+       #endif
+    }
+
+    static uint64 readCounter() noexcept
+    {
+       #if JUCE_INTEL
+        return (uint64) __rdtsc();
+       #else
+        return (uint64) Time::getHighResolutionTicks();
+       #endif
+    }
+
+    const AtomicHistogram& getHistogram (const Stage stage) const noexcept { return *stageHistograms[(int) stage]; }
+
+    /** Number of frames started in each `process()` call. */
+    const AtomicHistogram& getFramesPerProcessCall() const noexcept { return framesPerProcessCall; }
+
+    /** Background scheduling: number of times the audio thread had to wait for a frame of the background thread. */
+    uint64 getNumLateFrames() const noexcept { return numLateFrames.load (std::memory_order_relaxed); }
+
+    /** Background scheduling: number of times all frames were in use, so the audio thread had to wait before submitting another one. */
+    uint64 getNumStalledSubmissions() const noexcept { return numStalledSubmissions.load (std::memory_order_relaxed); }
+
+    /** Amortized scheduling: number of frames whose remaining tasks had to be processed at once. */
+    uint64 getNumForcedFrameCompletions() const noexcept { return numForcedFrameCompletions.load (std::memory_order_relaxed); }
+
+    /** Number of channels transformed forward or back by the processor (not by the frame callbacks), a batch counts each of its channels. */
+    uint64 getNumTransforms() const noexcept { return numTransforms.load (std::memory_order_relaxed); }
+
+    void reset() noexcept
+    {
+        for (auto* histogram : stageHistograms)
+            histogram->reset();
+
+        framesPerProcessCall.reset();
+        numLateFrames.store (0, std::memory_order_relaxed);
+        numStalledSubmissions.store (0, std::memory_order_relaxed);
+        numForcedFrameCompletions.store (0, std::memory_order_relaxed);
+        numTransforms.store (0, std::memory_order_relaxed);
+    }
+
+    /** Adds the time between its construction and destruction to the histogram of a stage. */
+    class ScopedMeasurement
+    {
+    public:
+        ScopedMeasurement (ProcessorStatistics& s, const Stage stageToMeasure) noexcept
+        : statistics (s), stage (stageToMeasure), start (readCounter())
+        {}
+
+        ~ScopedMeasurement()
+        {
+            statistics.stageHistograms[(int) stage]->add (readCounter() - start);
+        }
+
+    private:
+        ProcessorStatistics& statistics;
+        const Stage stage;
+        const uint64 start;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedMeasurement)
+    };
+
+private:
+    template <typename SampleType>
+    friend class BasicOverlappingFFTProcessor;
+
+    AtomicHistogram processHistogram { AtomicHistogram::Scale::logarithmic };
+    AtomicHistogram windowingHistogram { AtomicHistogram::Scale::logarithmic };
+    AtomicHistogram frameProcessingHistogram { AtomicHistogram::Scale::logarithmic };
+    AtomicHistogram writeBackHistogram { AtomicHistogram::Scale::logarithmic };
+    AtomicHistogram outputReadHistogram { AtomicHistogram::Scale::logarithmic };
+    AtomicHistogram* const stageHistograms[numStages] { &processHistogram, &windowingHistogram, &frameProcessingHistogram, &writeBackHistogram, &outputReadHistogram };
+
+    AtomicHistogram framesPerProcessCall { AtomicHistogram::Scale::linear };
+    std::atomic<uint64> numLateFrames { 0 }, numStalledSubmissions { 0 }, numForcedFrameCompletions { 0 }, numTransforms { 0 };
+
+    // only used by the audio thread
+    int numFramesInProcessCall = 0;
+};
+
+ #define OVERLAPPINGFFTPROCESSOR_MEASURE(stage) const ProcessorStatistics::ScopedMeasurement JUCE_JOIN_MACRO (statisticsMeasurement, __LINE__) (statistics, ProcessorStatistics::Stage::stage)
+ #define OVERLAPPINGFFTPROCESSOR_STATISTICS(...) __VA_ARGS__
+#else
+ #define OVERLAPPINGFFTPROCESSOR_MEASURE(stage)
+ #define OVERLAPPINGFFTPROCESSOR_STATISTICS(...)
+#endif
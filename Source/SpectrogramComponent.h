@@ -0,0 +1,95 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include "../JuceLibraryCode/JuceHeader.h"
+#include "SpectrumTap.h"
+
+/**
+ Scrolling spectrogram of the frames published to a SpectrumTap, rendered with OpenGL.
+ Each frame is drawn as one column into a circular image, the newest column is at the right edge.
+ */
+class SpectrogramComponent : public Component, private Timer
+{
+public:
+    SpectrogramComponent (SpectrumTap& tapToUse)
+    : tap (tapToUse), image (Image::RGB, numColumns, tapToUse.getMaximumNumValues(), true)
+    {
+        setOpaque (true);
+        openGLContext.attachTo (*this);
+        startTimerHz (30);
+    }
+
+    ~SpectrogramComponent()
+    {
+        openGLContext.detach();
+    }
+
+    void paint (Graphics& g) override
+    {
+        // the circular image is drawn in two parts, starting with the oldest column
+        const int width = getWidth();
+        const int height = getHeight();
+        const int split = width * (numColumns - writeColumn) / numColumns;
+
+        g.drawImage (image, 0, 0, split, height, writeColumn, 0, numColumns - writeColumn, image.getHeight());
+        g.drawImage (image, split, 0, width - split, height, 0, 0, writeColumn, image.getHeight());
+
+        g.setColour (Colours::white);
+        g.setFont (12.0f);
+        g.drawText ("dropped frames: " + String ((int64) tap.getNumDroppedFrames()), getLocalBounds().reduced (4), Justification::topLeft);
+    }
+
+private:
+    void timerCallback() override
+    {
+        const int numFrames = tap.readFrames ([this] (const SpectrumTap::Frame& frame) { drawColumn (frame); });
+
+        if (numFrames > 0)
+            repaint();
+    }
+
+    /** Draws the magnitudes of a frame in decibels into the next column, low frequencies at the bottom. */
+    void drawColumn (const SpectrumTap::Frame& frame)
+    {
+        const int numRows = image.getHeight();
+
+        for (int y = 0; y < numRows; ++y)
+        {
+            const int index = (numRows - 1 - y) * frame.numValues / numRows;
+            const float level = jlimit (0.0f, 1.0f, jmap (Decibels::gainToDecibels (frame.values[index], minimumLevelInDecibels),
+                                                          minimumLevelInDecibels, 0.0f, 0.0f, 1.0f));
+
+            image.setPixelAt (writeColumn, y, Colour::fromHSV (0.7f * (1.0f - level), 0.9f, level, 1.0f));
+        }
+
+        writeColumn = (writeColumn + 1) % numColumns;
+    }
+
+    static constexpr int numColumns = 512;
+    static constexpr float minimumLevelInDecibels = -100.0f;
+
+    SpectrumTap& tap;
+    OpenGLContext openGLContext;
+    Image image;
+    int writeColumn = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SpectrogramComponent)
+};
@@ -0,0 +1,239 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+template <typename SampleType>
+class BasicOverlappingFFTProcessor;
+
+/**
+ Lock-free single-producer single-consumer queue of magnitude spectra, e.g. for spectrum displays, spectrograms or
+ analysis threads. Attach it to an OverlappingFFTProcessor with `setSpectrumTap()`, which then publishes the magnitudes
+ of one channel of each frame (before the frame is processed) without ever locking or allocating. The magnitudes are
+ always published as float, also by processors in double precision.
+ If the consumer doesn't keep up, new frames are dropped, see `getNumDroppedFrames()`.
+
+ The magnitudes are scaled so a sine wave with amplitude 1 has a peak of about 1. They are either published per bin,
+ or decimated to logarithmically spaced bands (the maximum of the bins in each band, interpolated for bands narrower
+ than a bin).
+ */
+class SpectrumTap
+{
+public:
+    /** A published spectrum, only valid within the consumer's callback. */
+    struct Frame
+    {
+        const float* values; /**< magnitudes of the bins or bands, from low to high frequencies */
+        int numValues; /**< number of bands, or fftSize / 2 + 1 bins */
+        int fftSize; /**< fftSize of the frame's transform */
+        int64 position; /**< input sample position of the first sample of the frame */
+    };
+
+    /** Constructor, all memory is allocated here.
+     @param maximumFftSize the largest fftSize of the processor this tap will be attached to
+     @param numberOfBands number of logarithmically spaced bands, or 0 to publish all bins
+     @param capacity number of frames the queue can hold
+     @param channelToTap channel of the processor which is published
+     @param minimumFrequency lower edge of the first band in Hz
+     @param maximumFrequency upper edge of the last band in Hz
+     */
+    SpectrumTap (const int maximumFftSize, const int numberOfBands = 0, const int capacity = 32, const int channelToTap = 0,
+                 const float minimumFrequency = 20.0f, const float maximumFrequency = 20000.0f)
+    : maximumNumBins (maximumFftSize / 2 + 1), numBands (numberOfBands),
+      numValuesPerFrame (numberOfBands > 0 ? numberOfBands : maximumFftSize / 2 + 1),
+      channel (channelToTap), fifo (capacity + 1)
+    {
+        jassert (minimumFrequency > 0.0f && maximumFrequency > minimumFrequency);
+
+        frames.malloc ((size_t) (capacity + 1) * (size_t) numValuesPerFrame);
+        frameInfos.calloc ((size_t) capacity + 1);
+
+        bandEdges.malloc ((size_t) numBands + 1);
+        for (int band = 0; band <= numBands && numBands > 0; ++band)
+            bandEdges[band] = minimumFrequency * std::pow (maximumFrequency / minimumFrequency, (float) band / numBands);
+    }
+
+    int getNumBands() const noexcept { return numBands; }
+    int getChannel() const noexcept { return channel; }
+
+    /** Returns the largest number of values a frame can have. */
+    int getMaximumNumValues() const noexcept { return numValuesPerFrame; }
+
+    double getSampleRate() const noexcept { return sampleRate.load(); }
+
+    /** Returns the centre frequency of a band (geometric mean of its edges), or of a bin for the given fftSize. */
+    float getFrequency (const int index, const int fftSize) const noexcept
+    {
+        if (numBands > 0)
+            return std::sqrt (bandEdges[index] * bandEdges[index + 1]);
+
+        return (float) (index * getSampleRate() / fftSize);
+    }
+
+    //==============================================================================
+    /** Number of frames the consumer can read. */
+    int getNumReadyFrames() const noexcept { return fifo.getNumReady(); }
+
+    /** Number of frames which were dropped, as the queue was full. */
+    uint64 getNumDroppedFrames() const noexcept { return numDroppedFrames.load (std::memory_order_relaxed); }
+
+    /**
+     Calls `callback (const Frame&)` for all published frames (oldest first) and removes them from the queue.
+     Call it only from one consumer thread.
+     @returns the number of frames read
+     */
+    template <typename Callback>
+    int readFrames (Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        for (int i = 0; i < size1; ++i)
+            callback (getFrame (start1 + i));
+
+        for (int i = 0; i < size2; ++i)
+            callback (getFrame (start2 + i));
+
+        fifo.finishedRead (size1 + size2);
+        return size1 + size2;
+    }
+
+    /**
+     Calls `callback (const Frame&)` for the latest frame only and discards the others, e.g. for a spectrum display.
+     @returns false if there was no new frame
+     */
+    template <typename Callback>
+    bool readLatestFrame (Callback&& callback)
+    {
+        int start1, size1, start2, size2;
+        fifo.prepareToRead (fifo.getNumReady(), start1, size1, start2, size2);
+
+        if (size1 + size2 == 0)
+            return false;
+
+        callback (getFrame (size2 > 0 ? start2 + size2 - 1 : start1 + size1 - 1));
+        fifo.finishedRead (size1 + size2);
+        return true;
+    }
+
+private:
+    template <typename SampleType>
+    friend class BasicOverlappingFFTProcessor;
+
+    /** Called by the processor in `prepare()`. */
+    void prepare (const double newSampleRate, const int maximumFftSize)
+    {
+        // the tap can't hold spectra that large, create it with a larger maximumFftSize
+        jassert (maximumFftSize / 2 + 1 <= maximumNumBins);
+        ignoreUnused (maximumFftSize);
+
+        sampleRate = newSampleRate;
+    }
+
+    /** Producer: publishes the fftSize / 2 + 1 magnitudes, scaled with `gain`. */
+    template <typename SampleType>
+    void publish (const SampleType* magnitudes, const int fftSize, const int64 position, const SampleType gain) noexcept
+    {
+        jassert (fftSize / 2 + 1 <= maximumNumBins);
+
+        int start1, size1, start2, size2;
+        fifo.prepareToWrite (1, start1, size1, start2, size2);
+
+        if (size1 == 0)
+        {
+            numDroppedFrames.fetch_add (1, std::memory_order_relaxed);
+            return;
+        }
+
+        const int numBins = fftSize / 2 + 1;
+        float* values = frames + (size_t) start1 * (size_t) numValuesPerFrame;
+        auto& info = frameInfos[start1];
+        info.fftSize = fftSize;
+        info.position = position;
+
+        if (numBands == 0)
+        {
+            for (int bin = 0; bin < numBins; ++bin)
+                values[bin] = (float) (gain * magnitudes[bin]);
+            info.numValues = numBins;
+        }
+        else
+        {
+            const float binsPerHz = (float) (fftSize / getSampleRate());
+
+            for (int band = 0; band < numBands; ++band)
+            {
+                const float low = bandEdges[band] * binsPerHz;
+                const float high = bandEdges[band + 1] * binsPerHz;
+                const int firstBin = (int) std::ceil (low);
+                const int endBin = jmin ((int) std::ceil (high), numBins);
+                SampleType value = 0;
+
+                if (firstBin < endBin)
+                {
+                    for (int bin = firstBin; bin < endBin; ++bin)
+                        value = jmax (value, magnitudes[bin]);
+                }
+                else if (high < numBins - 1)
+                {
+                    // narrower than a bin
+                    const float centre = 0.5f * (low + high);
+                    const int bin = (int) centre;
+                    const SampleType fraction = centre - bin;
+                    value = (1 - fraction) * magnitudes[bin] + fraction * magnitudes[bin + 1];
+                }
+
+                values[band] = (float) (gain * value);
+            }
+
+            info.numValues = numBands;
+        }
+
+        fifo.finishedWrite (1);
+    }
+
+    struct SlotInfo
+    {
+        int numValues;
+        int fftSize;
+        int64 position;
+    };
+
+    Frame getFrame (const int index) const noexcept
+    {
+        const auto& info = frameInfos[index];
+        return { frames + (size_t) index * (size_t) numValuesPerFrame, info.numValues, info.fftSize, info.position };
+    }
+
+    const int maximumNumBins;
+    const int numBands;
+    const int numValuesPerFrame;
+    const int channel;
+
+    AbstractFifo fifo;
+    HeapBlock<float> frames;
+    HeapBlock<SlotInfo> frameInfos;
+    HeapBlock<float> bandEdges;
+    std::atomic<double> sampleRate { 48000.0 };
+    std::atomic<uint64> numDroppedFrames { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE (SpectrumTap)
+};
@@ -0,0 +1,294 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+
+/**
+ Multi-channel buffer of complex spectra, with separate arrays for the real and the imaginary parts
+ (split-complex). Each array starts at a 64 byte boundary and is padded to a multiple of 64 bytes,
+ so the kernels below can run over whole SIMD registers without any scalar tail. The padding is kept at zero.
+
+ Use it for the spectra you process with, e.g. filters, so they have the same layout as the frames'
+ spectra in `FrameDomain::splitComplex` and `FrameDomain::matrix`. SampleType is float or double.
+ */
+template <typename SampleType>
+class SplitComplexBuffer
+{
+public:
+    static constexpr int alignmentInBytes = 64;
+
+    SplitComplexBuffer() {}
+
+    SplitComplexBuffer (const int numberOfChannels, const int numberOfBins)
+    {
+        setSize (numberOfChannels, numberOfBins);
+    }
+
+    /** Allocates (and clears) the buffer. */
+    void setSize (const int newNumChannels, const int newNumBins)
+    {
+        constexpr int valuesPerAlignment = alignmentInBytes / (int) sizeof (SampleType);
+
+        numChannels = newNumChannels;
+        numBins = newNumBins;
+        stride = (newNumBins + valuesPerAlignment - 1) / valuesPerAlignment * valuesPerAlignment;
+
+        memory.calloc ((size_t) (2 * numChannels * stride + valuesPerAlignment));
+        const auto offset = (alignmentInBytes - ((pointer_sized_int) memory.get() & (alignmentInBytes - 1))) & (alignmentInBytes - 1);
+        data = memory.get() + offset / sizeof (SampleType);
+    }
+
+    /** Changes the number of bins without reallocating, they must not exceed the number of bins of `setSize()`. The padding is cleared. */
+    void setNumBins (const int newNumBins) noexcept
+    {
+        jassert (newNumBins <= stride);
+
+        if (newNumBins < numBins)
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                FloatVectorOperations::clear (getRealPointer (ch) + newNumBins, numBins - newNumBins);
+                FloatVectorOperations::clear (getImagPointer (ch) + newNumBins, numBins - newNumBins);
+            }
+
+        numBins = newNumBins;
+    }
+
+    int getNumChannels() const noexcept { return numChannels; }
+    int getNumBins() const noexcept { return numBins; }
+
+    /** Returns the number of bytes allocated by `setSize()`. */
+    size_t getSizeInBytes() const noexcept
+    {
+        return memory == nullptr ? 0 : (size_t) (2 * numChannels * stride) * sizeof (SampleType) + (size_t) alignmentInBytes;
+    }
+
+    SampleType* getRealPointer (const int channel) noexcept { return data + 2 * channel * stride; }
+    SampleType* getImagPointer (const int channel) noexcept { return data + (2 * channel + 1) * stride; }
+    const SampleType* getRealPointer (const int channel) const noexcept { return data + 2 * channel * stride; }
+    const SampleType* getImagPointer (const int channel) const noexcept { return data + (2 * channel + 1) * stride; }
+
+    /** Exchanges the contents of two buffers, only the pointers are swapped. */
+    void swapWith (SplitComplexBuffer& other) noexcept
+    {
+        std::swap (numChannels, other.numChannels);
+        std::swap (numBins, other.numBins);
+        std::swap (stride, other.stride);
+        memory.swapWith (other.memory);
+        std::swap (data, other.data);
+    }
+
+    void clear() noexcept
+    {
+        FloatVectorOperations::clear (data, 2 * numChannels * stride);
+    }
+
+    /** Copies the first `getNumBins()` bins of an interleaved spectrum (juce::dsp::FFT layout) into the channel. */
+    void copyFromInterleaved (const int channel, const SampleType* interleaved) noexcept
+    {
+        auto* re = getRealPointer (channel);
+        auto* im = getImagPointer (channel);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            re[k] = interleaved[2 * k];
+            im[k] = interleaved[2 * k + 1];
+        }
+    }
+
+    /** Writes the channel's bins as interleaved spectrum (juce::dsp::FFT layout). */
+    void copyToInterleaved (const int channel, SampleType* interleaved) const noexcept
+    {
+        const auto* re = getRealPointer (channel);
+        const auto* im = getImagPointer (channel);
+
+        for (int k = 0; k < numBins; ++k)
+        {
+            interleaved[2 * k] = re[k];
+            interleaved[2 * k + 1] = im[k];
+        }
+    }
+
+    //==============================================================================
+    /**
+     Multiplies all channels bin by bin with the spectra of `other`, which either has the same number of channels,
+     or a single channel which is applied to all channels (e.g. a filter).
+     */
+    void multiply (const SplitComplexBuffer& other) noexcept
+    {
+        jassert (other.stride == stride && (other.numChannels == numChannels || other.numChannels == 1));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const int otherCh = other.numChannels == 1 ? 0 : ch;
+            complexMultiply (getRealPointer (ch), getImagPointer (ch),
+                             getRealPointer (ch), getImagPointer (ch),
+                             other.getRealPointer (otherCh), other.getImagPointer (otherCh), false);
+        }
+    }
+
+    /**
+     Adds the bin by bin products of `a` and `b` to all channels (complex multiply-accumulate, e.g. for convolution
+     or beamforming). `a` and `b` either have the same number of channels as this buffer, or a single channel.
+     */
+    void addProductOf (const SplitComplexBuffer& a, const SplitComplexBuffer& b) noexcept
+    {
+        jassert (a.stride == stride && b.stride == stride);
+        jassert ((a.numChannels == numChannels || a.numChannels == 1) && (b.numChannels == numChannels || b.numChannels == 1));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const int aCh = a.numChannels == 1 ? 0 : ch;
+            const int bCh = b.numChannels == 1 ? 0 : ch;
+            complexMultiply (getRealPointer (ch), getImagPointer (ch),
+                             a.getRealPointer (aCh), a.getImagPointer (aCh),
+                             b.getRealPointer (bCh), b.getImagPointer (bCh), true);
+        }
+    }
+
+    /** Adds the bin by bin product of channel `aChannel` of `a` and channel `bChannel` of `b` to a single channel. */
+    void addProductOf (const int channel, const SplitComplexBuffer& a, const int aChannel, const SplitComplexBuffer& b, const int bChannel) noexcept
+    {
+        jassert (a.stride == stride && b.stride == stride);
+
+        complexMultiply (getRealPointer (channel), getImagPointer (channel),
+                         a.getRealPointer (aChannel), a.getImagPointer (aChannel),
+                         b.getRealPointer (bChannel), b.getImagPointer (bChannel), true);
+    }
+
+    /**
+     Sets the channels to the bin by bin product of a complex matrix with the spectra of `input` (e.g. beamforming,
+     Ambisonics decoding or upmixing): channel o is the sum of the products of channel `o * input.getNumChannels() + i`
+     of `matrix` with channel i of `input`, over all input channels i. The bins are processed in blocks, so the blocks
+     of the input spectra stay in the cache while all output channels are computed. `input` must not be this buffer.
+     */
+    void setToMatrixProduct (const SplitComplexBuffer& matrix, const SplitComplexBuffer& input) noexcept
+    {
+        jassert (matrix.stride == stride && input.stride == stride && &input != this);
+        jassert (matrix.numChannels == numChannels * input.numChannels);
+
+        const int numInputs = input.numChannels;
+
+        for (int start = 0; start < stride; start += binsPerMatrixBlock)
+        {
+            const int end = jmin (stride, start + binsPerMatrixBlock);
+
+            for (int out = 0; out < numChannels; ++out)
+            {
+                if (numInputs == 0)
+                {
+                    FloatVectorOperations::clear (getRealPointer (out) + start, end - start);
+                    FloatVectorOperations::clear (getImagPointer (out) + start, end - start);
+                }
+
+                for (int in = 0; in < numInputs; ++in)
+                    complexMultiply (getRealPointer (out), getImagPointer (out),
+                                     matrix.getRealPointer (out * numInputs + in), matrix.getImagPointer (out * numInputs + in),
+                                     input.getRealPointer (in), input.getImagPointer (in), in > 0, start, end);
+            }
+        }
+    }
+
+    /** Multiplies all channels with real-valued gains, one for each of the `getNumBins()` bins (e.g. a Wiener filter). */
+    void applyGains (const SampleType* gains) noexcept
+    {
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            FloatVectorOperations::multiply (getRealPointer (ch), gains, numBins);
+            FloatVectorOperations::multiply (getImagPointer (ch), gains, numBins);
+        }
+    }
+
+    /** Writes the squared magnitudes of the channel's bins into `destination` (`getNumBins()` values). */
+    void getPowers (const int channel, SampleType* destination) const noexcept
+    {
+        const auto* re = getRealPointer (channel);
+        const auto* im = getImagPointer (channel);
+
+        FloatVectorOperations::multiply (destination, re, re, numBins);
+        FloatVectorOperations::addWithMultiply (destination, im, im, numBins);
+    }
+
+    /** Writes the magnitudes of the channel's bins into `destination` (`getNumBins()` values). */
+    void getMagnitudes (const int channel, SampleType* destination) const noexcept
+    {
+        getPowers (channel, destination);
+
+        for (int k = 0; k < numBins; ++k)
+            destination[k] = std::sqrt (destination[k]);
+    }
+
+    /** Writes the phases of the channel's bins into `destination` (`getNumBins()` values). */
+    void getPhases (const int channel, SampleType* destination) const noexcept
+    {
+        const auto* re = getRealPointer (channel);
+        const auto* im = getImagPointer (channel);
+
+        for (int k = 0; k < numBins; ++k)
+            destination[k] = std::atan2 (im[k], re[k]);
+    }
+
+private:
+    using Register = dsp::SIMDRegister<SampleType>;
+
+    // a multiple of the SIMD width and of 64 bytes, small enough that a block of a few dozen input spectra stays in the cache
+    static constexpr int binsPerMatrixBlock = 256;
+
+    /** dest = a * b, or dest += a * b, over the whole (padded) arrays. dest may be the same as a or b. */
+    void complexMultiply (SampleType* destRe, SampleType* destIm, const SampleType* aRe, const SampleType* aIm, const SampleType* bRe, const SampleType* bIm, const bool accumulate) const noexcept
+    {
+        complexMultiply (destRe, destIm, aRe, aIm, bRe, bIm, accumulate, 0, stride);
+    }
+
+    /** dest = a * b, or dest += a * b, for the bins from start to end, which have to be multiples of the SIMD width. */
+    void complexMultiply (SampleType* destRe, SampleType* destIm, const SampleType* aRe, const SampleType* aIm, const SampleType* bRe, const SampleType* bIm,
+                          const bool accumulate, const int start, const int end) const noexcept
+    {
+        constexpr int step = (int) Register::SIMDNumElements;
+
+        for (int k = start; k < end; k += step)
+        {
+            const auto ar = Register::fromRawArray (aRe + k);
+            const auto ai = Register::fromRawArray (aIm + k);
+            const auto br = Register::fromRawArray (bRe + k);
+            const auto bi = Register::fromRawArray (bIm + k);
+
+            auto re = ar * br - ai * bi;
+            auto im = ar * bi + ai * br;
+
+            if (accumulate)
+            {
+                re += Register::fromRawArray (destRe + k);
+                im += Register::fromRawArray (destIm + k);
+            }
+
+            re.copyToRawArray (destRe + k);
+            im.copyToRawArray (destIm + k);
+        }
+    }
+
+    int numChannels = 0;
+    int numBins = 0;
+    int stride = 0;
+    HeapBlock<SampleType> memory;
+    SampleType* data = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE (SplitComplexBuffer)
+};
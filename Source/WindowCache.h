@@ -0,0 +1,102 @@
+/*
+ ==============================================================================
+ Author: Daniel Rudrich
+ https://github.com/DanielRudrich
+
+ This code is free: you can redistribute it and/or modify
+ it under the terms of the GNU General Public License as published by
+ the Free Software Foundation, either version 3 of the License, or
+ (at your option) any later version.
+
+ This code is distributed in the hope that it will be useful,
+ but WITHOUT ANY WARRANTY; without even the implied warranty of
+ MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ GNU General Public License for more details.
+
+ You should have received a copy of the GNU General Public License
+ along with this code.  If not, see <https://www.gnu.org/licenses/>.
+ ==============================================================================
+ */
+
+#pragma once
+#include <JuceHeader.h>
+#include <map>
+#include <vector>
+
+/**
+ Process-wide cache of immutable windows, used like FFTPlanCache with a SharedResourcePointer. Windows with the same
+ values are only stored once: all processors with the same resolution (and window) share them, instead of each one
+ keeping a copy of its own. A window is freed once the last processor using it has changed its resolution or is deleted.
+ */
+template <typename SampleType>
+class WindowCache
+{
+public:
+    using Window = std::vector<SampleType>;
+
+    WindowCache() {}
+
+    /**
+     Returns the cached window with the same values as `window`, or takes `window` over if there's none yet.
+     Don't call this from the audio thread.
+     */
+    std::shared_ptr<const Window> getWindow (Window&& window)
+    {
+        const ScopedLock sl (lock);
+        const auto hash = getHash (window);
+        std::shared_ptr<const Window> result;
+
+        for (auto it = windows.begin(); it != windows.end();)
+        {
+            auto cachedWindow = it->second.lock();
+
+            if (cachedWindow == nullptr)
+                it = windows.erase (it); // the last processor using it has let go
+            else
+            {
+                if (it->first == hash && *cachedWindow == window)
+                    result = cachedWindow;
+
+                ++it;
+            }
+        }
+
+        if (result == nullptr)
+        {
+            result.reset (new Window (std::move (window)));
+            windows.emplace (hash, result);
+        }
+
+        return result;
+    }
+
+    /** Returns the number of windows which are currently in use. */
+    int getNumWindows() const
+    {
+        const ScopedLock sl (lock);
+        int numWindows = 0;
+
+        for (auto& entry : windows)
+            numWindows += entry.second.expired() ? 0 : 1;
+
+        return numWindows;
+    }
+
+private:
+    /** FNV-1a over the values, so most windows only have to be compared to the ones with the same hash. */
+    static uint64 getHash (const Window& window) noexcept
+    {
+        uint64 hash = 14695981039346656037ull;
+        const auto* bytes = reinterpret_cast<const uint8*> (window.data());
+
+        for (size_t i = 0; i < window.size() * sizeof (SampleType); ++i)
+            hash = (hash ^ bytes[i]) * 1099511628211ull;
+
+        return hash;
+    }
+
+    CriticalSection lock;
+    std::multimap<uint64, std::weak_ptr<const Window>> windows;
+
+    JUCE_DECLARE_NON_COPYABLE (WindowCache)
+};